@@ -22,6 +22,7 @@
 ********************************************************************/
 
 #include "ldpc.h"
+#include "cache.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -127,3 +128,183 @@ ldpc_ll_matrix_t *ldpc_alist_parse(char *fname) {
         return NULL;
     }
 }
+
+/* Parse the rows of the alist file straight into the arrays of the compact form, in the
+ * same edge order as ldpc_code_create on the matrix of ldpc_alist_parse. Besides the
+ * compact form, only the check node degrees and one row are held while parsing.
+ */
+ldpc_code_t *ldpc_alist_load(char *fname) {
+    FILE *fp;
+    ldpc_code_t *code = NULL;
+    int N,M, max_cd, max_bd;
+    int *cdegs = NULL;
+    int *row = NULL;
+    int *fill = NULL; /* Next free position of each column in col_edge */
+    int i,j,e,col, num_edges;
+    int succ = 0;
+
+    if (!(fp = fopen(fname, "r"))) {
+        fprintf(stderr, "Error opening alist file %s\n", fname);
+        return NULL;
+    }
+    if (fscanf(fp, "%d %d %d %d ", &M, &N, &max_cd, &max_bd) != 4 || M <= 0 || N <= M || max_cd <= 0)
+        goto cleanup;
+    fprintf(stderr, "N: %d, M: %d, max_cd: %d, max_bd: %d\n", N, M, max_cd, max_bd);
+
+    cdegs = (int *)malloc(M * sizeof(int));
+    row = (int *)malloc(max_cd * sizeof(int));
+    if (!cdegs || !row)
+        goto cleanup;
+    for (i=0, num_edges=0;i<M;i++) {
+        if (fscanf(fp, "%d ", &cdegs[i]) != 1 || cdegs[i] < 0 || cdegs[i] > max_cd)
+            goto cleanup;
+        num_edges += cdegs[i];
+    }
+    /* The bit node degrees follow from the rows */
+    for (i=0;i<N;i++)
+        if (fscanf(fp, "%d ", &j) != 1)
+            goto cleanup;
+
+    code = (ldpc_code_t *)calloc(1, sizeof(ldpc_code_t));
+    if (!code)
+        goto cleanup;
+    code->M = M;
+    code->N = N;
+    code->K = N-M;
+    code->num_edges = num_edges;
+    code->index_size = N <= 65536 && num_edges <= 65536 ? 2 : 4;
+    code->row_start = (int *)malloc((M + 1) * sizeof(int));
+    code->col_start = (int *)calloc(N + 1, sizeof(int));
+    code->row_col = malloc((size_t)num_edges * code->index_size);
+    code->col_edge = malloc((size_t)num_edges * code->index_size);
+    fill = (int *)malloc(N * sizeof(int));
+    if (!code->row_start || !code->col_start || !code->row_col || !code->col_edge || !fill)
+        goto cleanup;
+
+    /* Rows in edge order, counting the degree of each column in col_start[col+1] */
+    for (i=0, e=0;i<M;i++) {
+        for (j=0;j<max_cd;j++)
+            if (fscanf(fp, "%d ", &row[j]) != 1)
+                goto cleanup;
+
+        code->row_start[i] = e;
+        for (j=0;j<cdegs[i];j++) {
+            col = row[j]-1;
+            if (col < 0 || col >= N)
+                goto cleanup;
+            ldpc_code_set(code, code->row_col, e++, col);
+            code->col_start[col+1]++;
+        }
+    }
+    code->row_start[M] = e;
+    fprintf(stderr, "edges: %d\n", e);
+
+    /* Each column lists its edges in increasing order */
+    for (i=0;i<N;i++) {
+        code->col_start[i+1] += code->col_start[i];
+        fill[i] = code->col_start[i];
+    }
+    for (e=0;e<num_edges;e++)
+        ldpc_code_set(code, code->col_edge, fill[ldpc_code_index(code, code->row_col, e)]++, e);
+    succ = 1;
+
+cleanup:
+    if (!succ)
+        fprintf(stderr, "Alist file %s: bad format\n", fname);
+    fclose(fp);
+    free(cdegs);
+    free(row);
+    free(fill);
+    if (!succ) {
+        ldpc_code_destroy(code);
+        code = NULL;
+    }
+
+    return code;
+}
+
+/* Key of the compact code of an alist file, a hash of its contents */
+static int ldpc_alist_key(char *fname, uint64_t *key) {
+    FILE *fp;
+    char *buf;
+    long size;
+    int fail;
+
+    if (!(fp = fopen(fname, "rb"))) {
+        fprintf(stderr, "Error opening alist file %s\n", fname);
+        return -1;
+    }
+    fail = fseek(fp, 0, SEEK_END) || (size = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET);
+    buf = fail ? NULL : (char *)malloc(size + 1);
+    fail = !buf || fread(buf, 1, size, fp) != (size_t)size;
+    fclose(fp);
+    if (fail) {
+        fprintf(stderr, "Error reading alist file %s\n", fname);
+        free(buf);
+        return -1;
+    }
+
+    *key = ldpc_cache_hash(ldpc_cache_hash(LDPC_CACHE_HASH_INIT, "alist", 5), buf, size);
+    free(buf);
+    return 0;
+}
+
+ldpc_code_t *ldpc_alist_load_cached(char *fname, const char *cache_dir) {
+    ldpc_cache_section_t s[5];
+    ldpc_code_t *code;
+    const int *dims;
+    uint64_t key;
+    size_t map_size;
+    void *map;
+    int dim[5];
+
+    if (!cache_dir)
+        return ldpc_alist_load(fname);
+    if (ldpc_alist_key(fname, &key))
+        return NULL;
+
+    /* Sections: M, N, K, num_edges and index_size, then the four arrays */
+    if ((map = ldpc_cache_map(cache_dir, "code", key, s, 5, &map_size))) {
+        dims = (const int *)s[0].data;
+        if (s[0].size == sizeof(dim) && (dims[4] == 2 || dims[4] == 4) &&
+            s[1].size == (dims[0] + 1)*sizeof(int) && s[2].size == (dims[1] + 1)*sizeof(int) &&
+            s[3].size == (size_t)dims[3]*dims[4] && s[4].size == (size_t)dims[3]*dims[4]) {
+            code = (ldpc_code_t *)calloc(1, sizeof(ldpc_code_t));
+            code->M = dims[0];
+            code->N = dims[1];
+            code->K = dims[2];
+            code->num_edges = dims[3];
+            code->index_size = dims[4];
+            code->row_start = (int *)s[1].data;
+            code->col_start = (int *)s[2].data;
+            code->row_col = (void *)s[3].data;
+            code->col_edge = (void *)s[4].data;
+            code->map = map;
+            code->map_size = map_size;
+            return code;
+        }
+        ldpc_cache_unmap(map, map_size);
+    }
+
+    code = ldpc_alist_load(fname);
+    if (!code)
+        return NULL;
+    dim[0] = code->M;
+    dim[1] = code->N;
+    dim[2] = code->K;
+    dim[3] = code->num_edges;
+    dim[4] = code->index_size;
+    s[0].data = dim;
+    s[0].size = sizeof(dim);
+    s[1].data = code->row_start;
+    s[1].size = (code->M + 1)*sizeof(int);
+    s[2].data = code->col_start;
+    s[2].size = (code->N + 1)*sizeof(int);
+    s[3].data = code->row_col;
+    s[3].size = (size_t)code->num_edges*code->index_size;
+    s[4].data = code->col_edge;
+    s[4].size = (size_t)code->num_edges*code->index_size;
+    ldpc_cache_store(cache_dir, "code", key, s, 5);
+
+    return code;
+}
@@ -27,3 +27,14 @@
  * and NULL otherwise
  */
 ldpc_ll_matrix_t *ldpc_alist_parse(char *fname);
+
+/* Parse file "fname" directly into the compact ldpc_code_t form, without building the
+ * linked lists. Returns NULL on failure.
+ */
+ldpc_code_t *ldpc_alist_load(char *fname);
+
+/* Like ldpc_alist_load, but keeps the compact code in cache_dir, keyed by a hash of
+ * the file contents, and maps it from there when the same file is loaded again,
+ * see cache.h. Without a cache_dir, the same as ldpc_alist_load.
+ */
+ldpc_code_t *ldpc_alist_load_cached(char *fname, const char *cache_dir);
@@ -0,0 +1,253 @@
+/*****************************************************************
+    Batching of frames of several codes for a decoder engine.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#include "batcher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BATCH 128
+
+/* Frames of one code waiting for decoding */
+typedef struct {
+    ldpc_t *h;
+    int in_len; /* Input LLRs per frame */
+    int k; /* Output bits per frame */
+    char *input; /* The batch being filled, in the layout of ldpc_decode */
+    unsigned char *output;
+    int count; /* Frames in the batch */
+    long seq[BATCH];
+    unsigned long long arrival[BATCH]; /* Push time in microseconds */
+} ldpc_batcher_queue_t;
+
+/* A frame not yet returned by ldpc_batcher_pop */
+typedef struct {
+    int code;
+    unsigned char done;
+    ldpc_status_t status;
+    unsigned char *bitval;
+    int bitval_len; /* Allocated length of bitval */
+} ldpc_batcher_result_t;
+
+struct ldpc_batcher_t {
+    ldpc_engine_t *e;
+    unsigned int max_wait_us;
+
+    ldpc_batcher_queue_t *queues; /* One per code */
+    int num_codes;
+
+    /* Results in push order, frame seq in results[seq & (capacity - 1)] */
+    ldpc_batcher_result_t *results;
+    long capacity; /* A power of two */
+    long head; /* Oldest frame not yet returned */
+    long tail; /* Next frame to be pushed */
+
+    ldpc_batcher_stats_t stats;
+};
+
+static unsigned long long ldpc_batcher_now_us(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec*1000000ULL + t.tv_nsec/1000;
+}
+
+/* Get the queue of a code, adding the codes registered in the engine since the last call */
+static ldpc_batcher_queue_t *ldpc_batcher_queue(ldpc_batcher_t *b, int code) {
+    ldpc_batcher_queue_t *q;
+    ldpc_t *h;
+
+    if (code < 0)
+        return NULL;
+    while (code >= b->num_codes) {
+        h = ldpc_engine_code(b->e, b->num_codes);
+        if (!h)
+            return NULL;
+        b->queues = (ldpc_batcher_queue_t *)realloc(b->queues, (b->num_codes + 1)*sizeof(ldpc_batcher_queue_t));
+        q = &b->queues[b->num_codes++];
+        memset(q, 0, sizeof(ldpc_batcher_queue_t));
+        q->h = h;
+        q->in_len = ldpc_decoder_input_size(h) / BATCH;
+        q->k = ldpc_decoder_output_size(h) / BATCH;
+        q->input = (char *)malloc(ldpc_decoder_input_size(h));
+        q->output = (unsigned char *)malloc(ldpc_decoder_output_size(h));
+    }
+
+    return &b->queues[code];
+}
+
+/* Make room for one more pending frame */
+static void ldpc_batcher_reserve(ldpc_batcher_t *b) {
+    ldpc_batcher_result_t *results;
+    long capacity;
+
+    if (b->tail - b->head < b->capacity)
+        return;
+
+    capacity = b->capacity*2;
+    results = (ldpc_batcher_result_t *)calloc(capacity, sizeof(ldpc_batcher_result_t));
+    for (long seq = b->head; seq < b->tail; seq++)
+        results[seq & (capacity - 1)] = b->results[seq & (b->capacity - 1)];
+    free(b->results);
+    b->results = results;
+    b->capacity = capacity;
+}
+
+/* Decode the batch of a queue, padded with zero LLRs if it is not full */
+static void ldpc_batcher_decode(ldpc_batcher_t *b, int code) {
+    ldpc_batcher_queue_t *q = &b->queues[code];
+    ldpc_batcher_result_t *r;
+    ldpc_status_t status[BATCH];
+    unsigned long long now, wait;
+
+    now = ldpc_batcher_now_us();
+    if (q->count < BATCH)
+        memset(q->input + q->count*q->in_len, 0, (BATCH - q->count)*q->in_len);
+
+    ldpc_engine_decode(b->e, code, q->input, q->output);
+    ldpc_decoder_status(q->h, status);
+
+    for (int i = 0; i < q->count; i++) {
+        r = &b->results[q->seq[i] & (b->capacity - 1)];
+        if (r->bitval_len < q->k) {
+            r->bitval = (unsigned char *)realloc(r->bitval, q->k);
+            r->bitval_len = q->k;
+        }
+        memcpy(r->bitval, q->output + i*q->k, q->k);
+        r->status = status[i];
+        r->done = 1;
+
+        wait = now - q->arrival[i];
+        b->stats.queue_us += wait;
+        if (wait > b->stats.max_queue_us)
+            b->stats.max_queue_us = wait;
+    }
+
+    b->stats.frames += q->count;
+    b->stats.batches++;
+    if (q->count < BATCH)
+        b->stats.timeout_batches++;
+    q->count = 0;
+}
+
+ldpc_batcher_t *ldpc_batcher_create(ldpc_engine_t *e, unsigned int max_wait_us) {
+    ldpc_batcher_t *b = (ldpc_batcher_t *)calloc(1, sizeof(ldpc_batcher_t));
+
+    b->e = e;
+    b->max_wait_us = max_wait_us;
+    b->capacity = 2*BATCH;
+    b->results = (ldpc_batcher_result_t *)calloc(b->capacity, sizeof(ldpc_batcher_result_t));
+
+    return b;
+}
+
+long ldpc_batcher_push(ldpc_batcher_t *b, int code, const char *llr) {
+    ldpc_batcher_queue_t *q = ldpc_batcher_queue(b, code);
+    ldpc_batcher_result_t *r;
+    long seq;
+
+    if (!q) {
+        fprintf(stderr, "Unknown code %d\n", code);
+        return -1;
+    }
+
+    ldpc_batcher_reserve(b);
+    seq = b->tail++;
+    r = &b->results[seq & (b->capacity - 1)];
+    r->code = code;
+    r->done = 0;
+
+    memcpy(q->input + q->count*q->in_len, llr, q->in_len);
+    q->seq[q->count] = seq;
+    q->arrival[q->count] = ldpc_batcher_now_us();
+    if (++q->count == BATCH)
+        ldpc_batcher_decode(b, code);
+
+    return seq;
+}
+
+int ldpc_batcher_poll(ldpc_batcher_t *b) {
+    unsigned long long now;
+    int num = 0;
+
+    if (!b->max_wait_us)
+        return 0;
+
+    now = ldpc_batcher_now_us();
+    for (int code = 0; code < b->num_codes; code++) {
+        if (b->queues[code].count && now - b->queues[code].arrival[0] >= b->max_wait_us) {
+            ldpc_batcher_decode(b, code);
+            num++;
+        }
+    }
+
+    return num;
+}
+
+int ldpc_batcher_flush(ldpc_batcher_t *b) {
+    int num = 0;
+
+    for (int code = 0; code < b->num_codes; code++) {
+        if (b->queues[code].count) {
+            ldpc_batcher_decode(b, code);
+            num++;
+        }
+    }
+
+    return num;
+}
+
+long ldpc_batcher_pop(ldpc_batcher_t *b, int *code, unsigned char *bitval, ldpc_status_t *status) {
+    ldpc_batcher_result_t *r;
+
+    if (b->head == b->tail)
+        return -1;
+    r = &b->results[b->head & (b->capacity - 1)];
+    if (!r->done)
+        return -1;
+
+    if (code)
+        *code = r->code;
+    memcpy(bitval, r->bitval, b->queues[r->code].k);
+    if (status)
+        *status = r->status;
+
+    return b->head++;
+}
+
+void ldpc_batcher_stats(ldpc_batcher_t *b, ldpc_batcher_stats_t *stats) {
+    *stats = b->stats;
+}
+
+void ldpc_batcher_destroy(ldpc_batcher_t *b) {
+    for (int code = 0; code < b->num_codes; code++) {
+        free(b->queues[code].input);
+        free(b->queues[code].output);
+    }
+    for (long i = 0; i < b->capacity; i++)
+        free(b->results[i].bitval);
+    free(b->queues);
+    free(b->results);
+    free(b);
+}
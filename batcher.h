@@ -0,0 +1,77 @@
+/*****************************************************************
+    Batching of frames of several codes for a decoder engine.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#ifndef BATCHER_H
+#define BATCHER_H
+
+#include "ldpc.h"
+
+/* Frames are queued per code of an ldpc_engine_t, one at a time and in any mix of
+ * codes. A code's batch is decoded as soon as it holds 128 frames, or, padded with
+ * zero LLRs, once its oldest frame has waited max_wait_us (see ldpc_batcher_poll).
+ * Results are returned in the order the frames were pushed.
+ * Decoding runs on the calling thread, inside ldpc_batcher_push, ldpc_batcher_poll
+ * and ldpc_batcher_flush.
+ */
+typedef struct ldpc_batcher_t ldpc_batcher_t;
+
+/* Batching statistics since ldpc_batcher_create */
+typedef struct {
+    unsigned long long frames; /* Frames decoded */
+    unsigned long long batches; /* Batches decoded */
+    unsigned long long timeout_batches; /* Batches decoded before they were full */
+    unsigned long long queue_us; /* Time from push to decoding, summed over frames */
+    unsigned long long max_queue_us; /* Longest time from push to decoding */
+} ldpc_batcher_stats_t;
+
+/* Create a batcher for the codes registered in e. max_wait_us of 0 only decodes full
+ * batches, and those flushed with ldpc_batcher_flush. Returns NULL on failure.
+ */
+ldpc_batcher_t *ldpc_batcher_create(ldpc_engine_t *e, unsigned int max_wait_us);
+
+/* Queue one frame of the given code, the ldpc_decoder_input_size(h)/128 LLRs of a
+ * codeword. Returns the sequence number of the frame (0 for the first frame pushed),
+ * or -1 for an unknown code.
+ */
+long ldpc_batcher_push(ldpc_batcher_t *b, int code, const char *llr);
+
+/* Decode the batches whose oldest frame has waited max_wait_us. Returns the number of batches decoded. */
+int ldpc_batcher_poll(ldpc_batcher_t *b);
+
+/* Decode all queued frames. Returns the number of batches decoded. */
+int ldpc_batcher_flush(ldpc_batcher_t *b);
+
+/* Get the result of the oldest frame not yet returned, if it is decoded. bitval receives
+ * the ldpc_decoder_output_size(h)/128 hard decisions of the codeword, and code and
+ * status may be NULL. Returns the sequence number of the frame, or -1 if it is not
+ * decoded yet or no frame is pending.
+ */
+long ldpc_batcher_pop(ldpc_batcher_t *b, int *code, unsigned char *bitval, ldpc_status_t *status);
+
+/* Get the batching statistics. The fill ratio of the batches is frames/(128*batches). */
+void ldpc_batcher_stats(ldpc_batcher_t *b, ldpc_batcher_stats_t *stats);
+
+/* Free the batcher. Frames not yet returned are dropped. */
+void ldpc_batcher_destroy(ldpc_batcher_t *b);
+
+#endif //BATCHER_H
@@ -0,0 +1,167 @@
+/*****************************************************************
+    On-disk cache of decoder tables.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#include "cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define LDPC_CACHE_ALIGN 64
+
+uint64_t ldpc_cache_hash(uint64_t h, const void *data, size_t size) {
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t w;
+
+    for (; size >= 8; size -= 8, p += 8) {
+        memcpy(&w, p, 8);
+        h = (h ^ w) * 0x9e3779b97f4a7c15ULL;
+        h ^= h >> 32;
+    }
+
+    /* The remaining bytes, with their number so that trailing zeros count */
+    w = size;
+    for (size_t i = 0; i < size; i++)
+        w |= (uint64_t)p[i] << (8*(i + 1));
+    h = (h ^ w) * 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 32;
+
+    return h;
+}
+
+static void ldpc_cache_path(char *path, size_t len, const char *dir, const char *kind, uint64_t key) {
+    snprintf(path, len, "%s/ldpc-%s-%016llx.cache", dir, kind, (unsigned long long)key);
+}
+
+static uint64_t ldpc_cache_checksum(const ldpc_cache_section_t *sections, int num_sections) {
+    uint64_t h = LDPC_CACHE_HASH_INIT;
+
+    for (int i = 0; i < num_sections; i++)
+        h = ldpc_cache_hash(h, sections[i].data, sections[i].size);
+
+    return h;
+}
+
+int ldpc_cache_store(const char *dir, const char *kind, uint64_t key, const ldpc_cache_section_t *sections, int num_sections) {
+    static const char pad[LDPC_CACHE_ALIGN];
+    ldpc_cache_header_t hdr;
+    char path[PATH_MAX], tmp[PATH_MAX + 32];
+    uint64_t offset;
+    FILE *fp;
+    int fail;
+
+    if (num_sections > LDPC_CACHE_MAX_SECTIONS)
+        return -1;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, LDPC_CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.version = LDPC_CACHE_VERSION;
+    hdr.num_sections = num_sections;
+    hdr.key = key;
+    hdr.checksum = ldpc_cache_checksum(sections, num_sections);
+    offset = sizeof(hdr);
+    for (int i = 0; i < num_sections; i++) {
+        offset = (offset + LDPC_CACHE_ALIGN - 1) & ~(uint64_t)(LDPC_CACHE_ALIGN - 1);
+        hdr.offset[i] = offset;
+        hdr.size[i] = sections[i].size;
+        offset += sections[i].size;
+    }
+    hdr.file_size = offset;
+
+    mkdir(dir, 0755);
+    ldpc_cache_path(path, sizeof(path), dir, kind, key);
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+    if (!(fp = fopen(tmp, "wb"))) {
+        fprintf(stderr, "Error writing cache file %s\n", tmp);
+        return -1;
+    }
+
+    fail = fwrite(&hdr, sizeof(hdr), 1, fp) != 1;
+    offset = sizeof(hdr);
+    for (int i = 0; i < num_sections && !fail; i++) {
+        fail = fwrite(pad, 1, hdr.offset[i] - offset, fp) != hdr.offset[i] - offset;
+        if (sections[i].size && !fail)
+            fail = fwrite(sections[i].data, sections[i].size, 1, fp) != 1;
+        offset = hdr.offset[i] + sections[i].size;
+    }
+    fail |= fclose(fp) != 0;
+
+    if (fail || rename(tmp, path)) {
+        fprintf(stderr, "Error writing cache file %s\n", path);
+        unlink(tmp);
+        return -1;
+    }
+
+    return 0;
+}
+
+void *ldpc_cache_map(const char *dir, const char *kind, uint64_t key, ldpc_cache_section_t *sections, int num_sections, size_t *map_size) {
+    const ldpc_cache_header_t *hdr;
+    char path[PATH_MAX];
+    struct stat st;
+    void *map;
+    int fd, i;
+
+    ldpc_cache_path(path, sizeof(path), dir, kind, key);
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return NULL;
+    if (fstat(fd, &st) || st.st_size < (off_t)sizeof(ldpc_cache_header_t)) {
+        close(fd);
+        fprintf(stderr, "Ignoring invalid cache file %s\n", path);
+        return NULL;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return NULL;
+
+    hdr = (const ldpc_cache_header_t *)map;
+    if (memcmp(hdr->magic, LDPC_CACHE_MAGIC, sizeof(hdr->magic)) || hdr->version != LDPC_CACHE_VERSION ||
+        hdr->key != key || hdr->num_sections != (uint32_t)num_sections || hdr->file_size != (uint64_t)st.st_size)
+        goto invalid;
+    for (i = 0; i < num_sections; i++) {
+        if (hdr->offset[i] % LDPC_CACHE_ALIGN || hdr->offset[i] < sizeof(ldpc_cache_header_t) ||
+            hdr->offset[i] > hdr->file_size || hdr->size[i] > hdr->file_size - hdr->offset[i])
+            goto invalid;
+        sections[i].data = (const char *)map + hdr->offset[i];
+        sections[i].size = hdr->size[i];
+    }
+    if (ldpc_cache_checksum(sections, num_sections) != hdr->checksum)
+        goto invalid;
+
+    *map_size = st.st_size;
+    return map;
+
+invalid:
+    fprintf(stderr, "Ignoring invalid cache file %s\n", path);
+    munmap(map, st.st_size);
+    return NULL;
+}
+
+void ldpc_cache_unmap(void *map, size_t map_size) {
+    munmap(map, map_size);
+}
@@ -0,0 +1,88 @@
+/*****************************************************************
+    On-disk cache of decoder tables.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#ifndef LDPC_CACHE_H
+#define LDPC_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Tables derived from an H matrix, such as the compact code parsed from an alist file
+ * or the decoder's reordered edge lists, can be kept in a cache directory on local
+ * disk, so that a restarted process maps them instead of building them again.
+ *
+ * A cache file is named by its kind and a 64-bit key, a hash of everything the tables
+ * are derived from. It holds a header and a number of sections, each starting at a
+ * 64-byte boundary. The header records the key and a checksum of the sections, and a
+ * file that does not match them is ignored, so a stale or damaged file is rebuilt
+ * rather than used. Files are written to a temporary name and renamed into place, so
+ * processes starting at the same time never see a partial file.
+ *
+ * The cache is only valid on the machine that wrote it, as the tables are stored in
+ * its byte order and type sizes.
+ */
+
+#define LDPC_CACHE_MAGIC "LDPCACHE"
+#define LDPC_CACHE_VERSION 1
+#define LDPC_CACHE_MAX_SECTIONS 16
+
+/* Initial value of ldpc_cache_hash */
+#define LDPC_CACHE_HASH_INIT 0xcbf29ce484222325ULL
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_sections;
+    uint64_t key;
+    uint64_t checksum; /* ldpc_cache_hash of the bytes following the header */
+    uint64_t file_size;
+    uint64_t offset[LDPC_CACHE_MAX_SECTIONS]; /* From the start of the file, 64-byte aligned */
+    uint64_t size[LDPC_CACHE_MAX_SECTIONS];
+} ldpc_cache_header_t;
+
+/* A section of a cache file */
+typedef struct {
+    const void *data;
+    size_t size;
+} ldpc_cache_section_t;
+
+/* Continue hash h over size bytes of data. The hash is computed over 64-bit words
+ * and is meant for cache keys and checksums, not for security.
+ */
+uint64_t ldpc_cache_hash(uint64_t h, const void *data, size_t size);
+
+/* Write the sections to the cache file of kind and key in dir, replacing any
+ * existing file. Returns 0 on success and -1 on failure.
+ */
+int ldpc_cache_store(const char *dir, const char *kind, uint64_t key, const ldpc_cache_section_t *sections, int num_sections);
+
+/* Map the cache file of kind and key in dir, if it exists and holds num_sections
+ * sections with a valid checksum. The sections are set to point into the read-only
+ * mapping, which is returned along with its size in map_size. Returns NULL if there
+ * is no valid file.
+ */
+void *ldpc_cache_map(const char *dir, const char *kind, uint64_t key, ldpc_cache_section_t *sections, int num_sections, size_t *map_size);
+
+void ldpc_cache_unmap(void *map, size_t map_size);
+
+#endif //LDPC_CACHE_H
@@ -0,0 +1,204 @@
+/*****************************************************************
+    Vectorized AWGN channel model for simulations and benchmarks.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#include "channel.h"
+#include <math.h>
+#include <string.h>
+
+#ifdef __SSE4__
+#include <smmintrin.h>
+#else
+#include <tmmintrin.h>
+#endif
+
+#define ROTL(x, r) (_mm_or_si128(_mm_slli_epi32(x, r), _mm_srli_epi32(x, 32 - (r))))
+#define TF_ROUND(r) x0 = _mm_add_epi32(x0, x1); x1 = ROTL(x1, r); x1 = _mm_xor_si128(x1, x0);
+#define TF_INJECT(ka, kb, n) x0 = _mm_add_epi32(x0, ka); x1 = _mm_add_epi32(x1, _mm_add_epi32(kb, _mm_set1_epi32(n)));
+
+/* Threefry-2x32-20 for four consecutive counters. Gives 8 random 32-bit words. */
+static inline void channel_threefry(channel_rng_t *rng, __m128i *out0, __m128i *out1) {
+    const uint64_t c = rng->counter;
+    const __m128i k0 = _mm_set1_epi32(rng->key[0]);
+    const __m128i k1 = _mm_set1_epi32(rng->key[1]);
+    const __m128i k2 = _mm_set1_epi32(0x1BD11BDA ^ rng->key[0] ^ rng->key[1]);
+    __m128i x0, x1;
+
+    x0 = _mm_setr_epi32((uint32_t)c, (uint32_t)(c+1), (uint32_t)(c+2), (uint32_t)(c+3));
+    x1 = _mm_setr_epi32((uint32_t)(c >> 32), (uint32_t)((c+1) >> 32), (uint32_t)((c+2) >> 32), (uint32_t)((c+3) >> 32));
+    x0 = _mm_add_epi32(x0, k0);
+    x1 = _mm_add_epi32(x1, k1);
+
+    TF_ROUND(13) TF_ROUND(15) TF_ROUND(26) TF_ROUND(6)
+    TF_INJECT(k1, k2, 1)
+    TF_ROUND(17) TF_ROUND(29) TF_ROUND(16) TF_ROUND(24)
+    TF_INJECT(k2, k0, 2)
+    TF_ROUND(13) TF_ROUND(15) TF_ROUND(26) TF_ROUND(6)
+    TF_INJECT(k0, k1, 3)
+    TF_ROUND(17) TF_ROUND(29) TF_ROUND(16) TF_ROUND(24)
+    TF_INJECT(k1, k2, 4)
+    TF_ROUND(13) TF_ROUND(15) TF_ROUND(26) TF_ROUND(6)
+    TF_INJECT(k2, k0, 5)
+
+    rng->counter += 4;
+    *out0 = x0;
+    *out1 = x1;
+}
+
+/* Uniform floats in (0,1) from random words */
+static inline __m128 channel_uniform_ps(__m128i x) {
+    __m128 u = _mm_cvtepi32_ps(_mm_srli_epi32(x, 8));
+    return _mm_mul_ps(_mm_add_ps(u, _mm_set1_ps(0.5f)), _mm_set1_ps(1.0f/16777216.0f));
+}
+
+/* Natural logarithm of positive, normal floats (Cephes polynomial) */
+static inline __m128 channel_log_ps(__m128 x) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128i xi = _mm_castps_si128(x);
+    __m128 e, m, mask, z, y;
+
+    /* x = m * 2^e, 0.5 <= m < 1 */
+    e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(xi, 23), _mm_set1_epi32(126)));
+    m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(xi, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F000000)));
+
+    /* Keep m in [sqrt(0.5), sqrt(2)) around 1 */
+    mask = _mm_cmplt_ps(m, _mm_set1_ps(0.707106781186547524f));
+    e = _mm_sub_ps(e, _mm_and_ps(one, mask));
+    m = _mm_add_ps(_mm_sub_ps(m, one), _mm_and_ps(m, mask));
+
+    z = _mm_mul_ps(m, m);
+    y = _mm_set1_ps(7.0376836292E-2f);
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.1514610310E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.1676998740E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.2420140846E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(1.4249322787E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-1.6668057665E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(2.0000714765E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(-2.4999993993E-1f));
+    y = _mm_add_ps(_mm_mul_ps(y, m), _mm_set1_ps(3.3333331174E-1f));
+    y = _mm_mul_ps(_mm_mul_ps(y, m), z);
+
+    y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+    y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    m = _mm_add_ps(m, y);
+    return _mm_add_ps(m, _mm_mul_ps(e, _mm_set1_ps(0.693359375f)));
+}
+
+/* Eight standard normal samples using the Box-Muller transform.
+ * The angle is drawn as a quadrant plus an offset in [-pi/4, pi/4), so sine and
+ * cosine only need short polynomials. Rotating the whole circle by pi/4 does not
+ * change the distribution.
+ */
+static inline void channel_normal(channel_rng_t *rng, __m128 *n0, __m128 *n1) {
+    const __m128 signmask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+    __m128i x0, x1, q;
+    __m128 r, t, f, z, s, c, swap, a, b;
+
+    channel_threefry(rng, &x0, &x1);
+
+    r = _mm_sqrt_ps(_mm_mul_ps(_mm_set1_ps(-2.0f), channel_log_ps(channel_uniform_ps(x0))));
+
+    /* Quadrant q in 0..3 and offset f in [-pi/4, pi/4) */
+    q = _mm_srli_epi32(x1, 30);
+    t = _mm_cvtepi32_ps(_mm_srli_epi32(_mm_slli_epi32(x1, 2), 9));
+    f = _mm_mul_ps(_mm_add_ps(t, _mm_set1_ps(0.5f - 4194304.0f)), _mm_set1_ps(1.5707963267948966f/8388608.0f));
+
+    z = _mm_mul_ps(f, f);
+    s = _mm_set1_ps(-1.9515295891E-4f);
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(8.3321608736E-3f));
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(-1.6666654611E-1f));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), f), f);
+    c = _mm_set1_ps(2.443315711809948E-005f);
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(-1.388731625493765E-003f));
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(4.166664568298827E-002f));
+    c = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(c, z), z), _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(z, _mm_set1_ps(0.5f))));
+
+    /* Rotate (c, s) by q*pi/2: q=1 -> (-s, c), q=2 -> (-c, -s), q=3 -> (s, -c) */
+    swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    a = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+    b = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+    a = _mm_xor_ps(a, _mm_and_ps(signmask, _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_srli_epi32(_mm_add_epi32(q, _mm_set1_epi32(1)), 1), _mm_set1_epi32(1)))));
+    b = _mm_xor_ps(b, _mm_and_ps(signmask, _mm_castsi128_ps(_mm_cmpgt_epi32(q, _mm_set1_epi32(1)))));
+
+    *n0 = _mm_mul_ps(r, a);
+    *n1 = _mm_mul_ps(r, b);
+}
+
+void channel_rng_init(channel_rng_t *rng, uint64_t seed, uint32_t stream) {
+    rng->key[0] = (uint32_t)seed ^ stream;
+    rng->key[1] = (uint32_t)(seed >> 32) ^ (stream * 0x9E3779B9u);
+    rng->counter = 0;
+}
+
+void channel_random_bits(channel_rng_t *rng, char *bits, int len) {
+    uint32_t w[8];
+    __m128i x0, x1;
+    int i, j;
+
+    for (i = 0; i < len; i += 256) {
+        channel_threefry(rng, &x0, &x1);
+        _mm_storeu_si128((__m128i *)&w[0], x0);
+        _mm_storeu_si128((__m128i *)&w[4], x1);
+        for (j = 0; j < 256 && i + j < len; j++)
+            bits[i + j] = (w[j >> 5] >> (j & 31)) & 1;
+    }
+}
+
+/* Load 4 bits (one per byte) as BPSK symbols */
+static inline __m128 channel_bpsk_ps(const char *bits) {
+    const __m128i zero = _mm_setzero_si128();
+    int w;
+    __m128i b;
+
+    memcpy(&w, bits, sizeof(w));
+    b = _mm_cvtsi32_si128(w);
+
+    b = _mm_unpacklo_epi16(_mm_unpacklo_epi8(b, zero), zero);
+    return _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(2.0f), _mm_cvtepi32_ps(b)));
+}
+
+void channel_awgn_bpsk(channel_rng_t *rng, const char *bits, int len, float sigma, float *llr) {
+    const __m128 sym_scale = _mm_set1_ps(2.0f / (sigma*sigma));
+    const __m128 noise_scale = _mm_set1_ps(2.0f / sigma);
+    float tail[8];
+    __m128 n0, n1;
+    int i;
+
+    /* llr = 2y/sigma^2 = 2x/sigma^2 + 2n/sigma for a standard normal n */
+    for (i = 0; i + 8 <= len; i += 8) {
+        channel_normal(rng, &n0, &n1);
+        _mm_storeu_ps(llr + i, _mm_add_ps(_mm_mul_ps(channel_bpsk_ps(bits + i), sym_scale), _mm_mul_ps(n0, noise_scale)));
+        _mm_storeu_ps(llr + i + 4, _mm_add_ps(_mm_mul_ps(channel_bpsk_ps(bits + i + 4), sym_scale), _mm_mul_ps(n1, noise_scale)));
+    }
+
+    if (i < len) {
+        channel_normal(rng, &n0, &n1);
+        _mm_storeu_ps(tail, n0);
+        _mm_storeu_ps(tail + 4, n1);
+        for (int j = 0; i < len; i++, j++)
+            llr[i] = (bits[i] ? -1.0f : 1.0f) * (2.0f / (sigma*sigma)) + tail[j] * (2.0f / sigma);
+    }
+}
+
+float channel_sigma(float ebn0_db, float rate) {
+    return sqrtf(1.0f / (2.0f * rate * powf(10.0f, ebn0_db / 10.0f)));
+}
@@ -0,0 +1,51 @@
+/*****************************************************************
+    Vectorized AWGN channel model for simulations and benchmarks.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <stdint.h>
+
+/* Counter-based random number generator (Threefry-2x32-20).
+ * The output only depends on (seed, stream, counter), so each thread or batch
+ * can use its own stream and results are reproducible regardless of scheduling.
+ */
+typedef struct {
+    uint32_t key[2];
+    uint64_t counter;
+} channel_rng_t;
+
+void channel_rng_init(channel_rng_t *rng, uint64_t seed, uint32_t stream);
+
+/* Fill bits with len random bits (one bit per byte) */
+void channel_random_bits(channel_rng_t *rng, char *bits, int len);
+
+/* Add standard normal noise with standard deviation sigma to BPSK symbols
+ * (0 -> +1, 1 -> -1) of len bits, and produce channel LLRs 2y/sigma^2.
+ */
+void channel_awgn_bpsk(channel_rng_t *rng, const char *bits, int len, float sigma, float *llr);
+
+/* Noise standard deviation for a given Eb/N0 in dB and code rate */
+float channel_sigma(float ebn0_db, float rate);
+
+#endif //CHANNEL_H
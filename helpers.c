@@ -1,5 +1,5 @@
 /*****************************************************************
-    Some helper macros for benchmarking and CUDA functions
+    Some helper functions
 
     Copyright (C) 2013 Stefan Grönroos
 
@@ -24,23 +24,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-// For benchmarking
-#ifdef BENCHMARKING
-struct timespec time1[5], time2;
-struct timespec diff(struct timespec start, struct timespec end)
-{
-        struct timespec temp;
-        if ((end.tv_nsec-start.tv_nsec)<0) {
-                temp.tv_sec = end.tv_sec-start.tv_sec-1;
-                temp.tv_nsec = 1000000000+end.tv_nsec-start.tv_nsec;
-        } else {
-                temp.tv_sec = end.tv_sec-start.tv_sec;
-                temp.tv_nsec = end.tv_nsec-start.tv_nsec;
-        }
-        return temp;
-}
-#endif
-
 /* Convert a character array to a one byte per bit format */
 char *bits_to_bytes(int len, char *in)
 {
@@ -1,5 +1,5 @@
 /*****************************************************************
-    Some helper macros for benchmarking and CUDA functions
+    Some helper functions and CUDA includes
 
     Copyright (C) 2013 Stefan Grönroos
 
@@ -25,27 +25,5 @@
 #include <cutil.h>
 #endif
 
-#ifdef BENCHMARKING
-#include <time.h>
-
-/* Simple benchmarking macros. See also helpers.c
- * Use START_CLOCK(x) to start timer 0-4
- * Use BENCHMARK_NOW(x, "String") to output a benchmark message telling the time difference between
- * calling START_CLOCK and now. x is here also a timer ID (0-4)
- */
-
-extern struct timespec time1[5], time2;
-#define CLOCK_TYPE CLOCK_REALTIME /* CLOCK_REALTIME; CLOCK_PROCESS_CPUTIME_ID */
-#define START_CLOCK(id) extern struct timespec time1[5], time2; clock_gettime(CLOCK_TYPE, &time1[id]);
-#define BENCHMARK_NOW(id, string) clock_gettime(CLOCK_TYPE, &time2); \
-                                printf("\nBenchmark: " string ": %i:%i (%Lf)\n", (int)diff(time1[id],time2).tv_sec, (int)diff(time1[id],time2).tv_nsec, \
-                                        (long double)diff(time1[id],time2).tv_sec + (long double)diff(time1[id],time2).tv_nsec/1000000000.0);
-struct timespec diff(struct timespec start, struct timespec end);
-#else
-/* empty macros if benchmarking not enabled */
-#define START_CLOCK(id)
-#define BENCHMARK_NOW(id, string)
-#endif
-
 char *bits_to_bytes(char *in);
 
@@ -21,6 +21,7 @@
 ********************************************************************/
 
 #include "ldpc.h"
+#include "cache.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -51,17 +52,140 @@ void ldpc_ll_matrix_destroy(ldpc_ll_matrix_t *H) {
 
 void ldpc_param_init(ldpc_param_t *param)
 {
+    param->code = NULL;
     param->h_matrix = NULL;
     param->max_iter = 30; /* Default to 30 iterations */
+    param->num_threads = 1;
+    param->early_termination = 1;
+    param->sign_parity = 0;
+    param->prefetch_distance = 4;
+    param->algorithm = LDPC_MIN_SUM;
+    param->offset = 1;
+    param->alpha = 0.875f;
+    param->precision = LDPC_PRECISION_8;
+    param->reorder = LDPC_REORDER_NONE;
+    param->llr_scaling = LDPC_LLR_SCALE_FIXED;
+    param->llr_scale = 4.0f;
+    param->llr_target = 12.0f;
+    param->soft_output = LDPC_SOFT_APP;
+    param->soft_output_parity = 0;
+    param->bf_max_iter = 0;
+    param->bf_threshold = 8;
+    param->shortened = NULL;
+    param->num_shortened = 0;
+    param->punctured = NULL;
+    param->num_punctured = 0;
+    param->deadline_us = 0;
+    param->iter_budget = 0;
+    param->iter_budget_max = 0;
+    param->cache_dir = NULL;
 
     return;
 }
 
 void ldpc_param_destroy(ldpc_param_t *param)
 {
+    ldpc_code_destroy(param->code);
     ldpc_ll_matrix_destroy(param->h_matrix);
 }
 
+ldpc_code_t *ldpc_code_create(const ldpc_ll_matrix_t *H)
+{
+    ldpc_code_t *code;
+    ldpc_ll_edge_t *node;
+    int *edge_pos; /* Row-order number of each edge, by its index in H */
+    int i, e;
+
+    code = (ldpc_code_t *)calloc(1, sizeof(ldpc_code_t));
+    edge_pos = (int *)malloc(H->num_edges * sizeof(int));
+    if (!code || !edge_pos) {
+        free(code);
+        free(edge_pos);
+        return NULL;
+    }
+    code->M = H->M;
+    code->N = H->N;
+    code->K = H->K;
+    code->num_edges = H->num_edges;
+    code->index_size = H->N <= 65536 && H->num_edges <= 65536 ? 2 : 4;
+    code->row_start = (int *)malloc((H->M + 1) * sizeof(int));
+    code->col_start = (int *)malloc((H->N + 1) * sizeof(int));
+    code->row_col = malloc((size_t)H->num_edges * code->index_size);
+    code->col_edge = malloc((size_t)H->num_edges * code->index_size);
+    if (!code->row_start || !code->col_start || !code->row_col || !code->col_edge) {
+        free(edge_pos);
+        ldpc_code_destroy(code);
+        return NULL;
+    }
+
+    for (i = 0, e = 0; i < H->M; i++) {
+        code->row_start[i] = e;
+        for (node = H->rows[i]; node; node = node->right) {
+            ldpc_code_set(code, code->row_col, e, node->col);
+            edge_pos[node->idx] = e++;
+        }
+    }
+    code->row_start[H->M] = e;
+
+    for (i = 0, e = 0; i < H->N; i++) {
+        code->col_start[i] = e;
+        for (node = H->cols[i]; node; node = node->down)
+            ldpc_code_set(code, code->col_edge, e++, edge_pos[node->idx]);
+    }
+    code->col_start[H->N] = e;
+
+    free(edge_pos);
+    return code;
+}
+
+void ldpc_code_destroy(ldpc_code_t *code)
+{
+    if (!code)
+        return;
+    if (code->map) {
+        ldpc_cache_unmap(code->map, code->map_size);
+    } else {
+        free(code->row_start);
+        free(code->col_start);
+        free(code->row_col);
+        free(code->col_edge);
+    }
+    free(code);
+}
+
+ldpc_code_t *ldpc_param_code(ldpc_param_t *param)
+{
+    if (!param->code && param->h_matrix)
+        param->code = ldpc_code_create(param->h_matrix);
+    return param->code;
+}
+
+int ldpc_param_compact(ldpc_param_t *param)
+{
+    if (!ldpc_param_code(param))
+        return -1;
+    ldpc_ll_matrix_destroy(param->h_matrix);
+    param->h_matrix = NULL;
+    return 0;
+}
+
+void ldpc_llr_pack(const char *llr, int len, int bits, unsigned char *packed)
+{
+    int max = (1 << (bits - 1)) - 1;
+    int i, v, pos, s;
+
+    memset(packed, 0, ((size_t)len*bits + 7)/8);
+    for (i = 0; i < len; i++) {
+        v = llr[i] > max ? max : llr[i] < -max ? -max : llr[i];
+        v &= (1 << bits) - 1;
+        pos = i*bits;
+        s = pos & 7;
+        packed[pos >> 3] |= v << s;
+        if (s + bits > 8)
+            packed[(pos >> 3) + 1] |= v >> (8 - s);
+    }
+}
+
 
 /* For now, encodes a K*128 byte array (one bit per byte)
  * Warning! This function is not created for speed, but only for testing.
@@ -69,26 +193,23 @@ void ldpc_param_destroy(ldpc_param_t *param)
  */
 int ldpc_encode_c(ldpc_param_t *p, int len, char *input, char *output)
 {
-    int bit;
-    ldpc_ll_edge_t *node;
+    int bit, e;
+    ldpc_code_t *code = ldpc_param_code(p);
 
-    if (p->h_matrix && len == p->h_matrix->K)
+    if (code && len == code->K)
     {
         /* The first K bits in the encoded codeword are identical to the input */
-        memcpy(output, input, p->h_matrix->K*sizeof(char));
+        memcpy(output, input, code->K*sizeof(char));
 
         /* Zero out the rest of the output data */
-        memset( (void *)(output+p->h_matrix->K), 0, p->h_matrix->M*sizeof(char) );
+        memset( (void *)(output+code->K), 0, code->M*sizeof(char) );
 
-        /* Calculate the parity bits */
-        for (bit=0;bit<p->h_matrix->M;bit++)
+        /* Calculate the parity bits, from all edges of the row except the last, the parity bit itself */
+        for (bit=0;bit<code->M;bit++)
         {
-            output[p->h_matrix->K + bit] = 0;
-            node = p->h_matrix->rows[bit];
-            do {
-                output[p->h_matrix->K + bit] ^= output[node->col];
-                node = node->right;
-            } while(node->right);
+            output[code->K + bit] = 0;
+            for (e = code->row_start[bit]; e < code->row_start[bit+1] - 1; e++)
+                output[code->K + bit] ^= output[ldpc_code_index(code, code->row_col, e)];
         }
 
     }
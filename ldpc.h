@@ -24,8 +24,10 @@
 #define LDPC_H
 
 #include <stdio.h>
+#include <time.h>
 
 typedef struct ldpc_t ldpc_t; //Decoder handle
+typedef struct ldpc_engine_t ldpc_engine_t; //Decoder engine shared by several codes
 
 /* Intermediate format for representing the LDPC H matrix, using linked lists */
 typedef struct ldpc_ll_edge_t {
@@ -40,15 +42,200 @@ typedef struct {
     ldpc_ll_edge_t **cols;
 } ldpc_ll_matrix_t;
 
+/* Compact form of the H matrix, used by the encoder and by ldpc_init.
+ * The edges are numbered in row order. Row i holds edges row_start[i]..row_start[i+1]-1,
+ * with their columns in row_col, and column j lists its edges in increasing order in
+ * col_edge[col_start[j]..col_start[j+1]-1]. row_col and col_edge hold 16-bit indices
+ * when N and the number of edges allow it, and 32-bit indices otherwise, see
+ * ldpc_code_index.
+ */
+typedef struct {
+    int M,N,K, num_edges;
+    int index_size; /* Bytes per index in row_col and col_edge, 2 or 4 */
+    int *row_start; /* M+1 offsets */
+    int *col_start; /* N+1 offsets */
+    void *row_col;
+    void *col_edge;
+    /* Read-only cache file mapping holding the arrays, or NULL if they are allocated,
+     * see ldpc_alist_load_cached
+     */
+    void *map;
+    size_t map_size;
+} ldpc_code_t;
+
+/* Index i of row_col or col_edge */
+static inline int ldpc_code_index(const ldpc_code_t *code, const void *indices, int i) {
+    return code->index_size == 2 ? ((const unsigned short *)indices)[i] : ((const int *)indices)[i];
+}
+
+/* Set index i of row_col or col_edge */
+static inline void ldpc_code_set(const ldpc_code_t *code, void *indices, int i, int v) {
+    if (code->index_size == 2)
+        ((unsigned short *)indices)[i] = v;
+    else
+        ((int *)indices)[i] = v;
+}
+
+/* Check node update rule used by the decoder */
+typedef enum {
+    LDPC_MIN_SUM = 0,           /* Plain min-sum */
+    LDPC_OFFSET_MIN_SUM,        /* Offset min-sum: check node magnitudes are reduced by offset */
+    LDPC_NORMALIZED_MIN_SUM     /* Normalized min-sum: check node magnitudes are scaled by alpha */
+} ldpc_algorithm_t;
+
+/* Width of the messages passed between bit and check nodes */
+typedef enum {
+    LDPC_PRECISION_8 = 0,       /* Saturating 8-bit messages (16 codewords per SIMD vector) */
+    LDPC_PRECISION_16           /* Saturating 16-bit messages (8 codewords per SIMD vector) */
+} ldpc_precision_t;
+
+/* How float LLRs are quantized to the decoder's fixed-point format */
+typedef enum {
+    LDPC_LLR_SCALE_FIXED = 0,   /* Multiply all LLRs by llr_scale */
+    LDPC_LLR_SCALE_ADAPTIVE     /* Scale each frame so its mean |LLR| becomes llr_target */
+} ldpc_llr_scaling_t;
+
+/* Type of soft output produced by ldpc_decode_soft */
+typedef enum {
+    LDPC_SOFT_APP = 0,          /* A-posteriori LLRs */
+    LDPC_SOFT_EXTRINSIC         /* Extrinsic LLRs, i.e. a-posteriori minus channel LLRs */
+} ldpc_soft_output_t;
+
+/* Renumbering of check nodes, bit nodes and edges at decoder initialization.
+ * The decoder's input and output always use the bit order of the H matrix.
+ */
+typedef enum {
+    LDPC_REORDER_NONE = 0,      /* Keep the order of the H matrix */
+    LDPC_REORDER_DEGREE,        /* Group check nodes and bit nodes by degree */
+    LDPC_REORDER_RCM            /* Reverse Cuthill-McKee ordering of the Tanner graph */
+} ldpc_reorder_t;
+
+/* Decoding result of one codeword, see ldpc_decoder_status */
+typedef struct {
+    unsigned char valid; /* 1 if the decoded codeword satisfies all parity checks */
+    /* Iterations needed to converge, or iterations run if the codeword was not valid.
+     * Without early_termination, the parity is not checked between iterations, and this
+     * is always the number of iterations run.
+     */
+    unsigned short iterations;
+    unsigned char cut_off; /* 1 if the codeword was not valid when the deadline or iteration budget stopped the decoder */
+} ldpc_status_t;
+
+/* Maximum number of worker threads reported in ldpc_stats_t */
+#define LDPC_STATS_MAX_THREADS 128
+
+/* Node degrees reported separately in ldpc_stats_t, higher degrees are counted in the last entry */
+#define LDPC_STATS_MAX_DEGREE 64
+
+/* Decoder statistics, accumulated over all decode calls since ldpc_init or
+ * ldpc_decoder_stats_reset, see ldpc_decoder_stats.
+ * Times are in time stamp counter (TSC) cycles.
+ */
+typedef struct {
+    unsigned long long interleave_cycles; /* Interleaving (and quantizing) the input LLRs */
+    unsigned long long bf_cycles; /* Bit-flipping stage */
+    unsigned long long iteration_cycles; /* Message passing iterations */
+    unsigned long long hard_decision_cycles; /* Final bit node pass with hard decisions and parity check */
+    unsigned long long copy_back_cycles; /* De-interleaving the hard decisions and soft output */
+
+    /* Time each worker thread spent waiting in barriers */
+    int num_threads;
+    unsigned long long bn_wait_cycles[LDPC_STATS_MAX_THREADS];
+    unsigned long long cn_wait_cycles[LDPC_STATS_MAX_THREADS];
+
+    /* Time spent updating the check nodes and bit nodes of each degree, summed over threads */
+    unsigned long long cn_degree_cycles[LDPC_STATS_MAX_DEGREE];
+    unsigned long long bn_degree_cycles[LDPC_STATS_MAX_DEGREE];
+
+    unsigned long long batches; /* Decoded batches of 128 codewords */
+    unsigned long long iterations; /* Iterations executed, summed over batches */
+    unsigned long long frames; /* Decoded codewords */
+    unsigned long long failed_frames; /* Decoded codewords not satisfying all parity checks */
+    unsigned long long bf_frames; /* Codewords valid after the bit-flipping stage */
+    unsigned long long bf_batches; /* Batches decoded by the bit-flipping stage alone */
+    unsigned long long cut_off_frames; /* Codewords cut off by the deadline or iteration budget */
+} ldpc_stats_t;
+
 /* Decoder initialization parameters */
 typedef struct ldpc_param_t {
-    /* To initialize the decoder with a certain code,
-     * supply an ldpc_ll_matrix_t containing the H matrix
+    /* To initialize the decoder with a certain code, supply the H matrix, either
+     * compact in code, or as an ldpc_ll_matrix_t in h_matrix. The compact form is
+     * built from h_matrix when it is first needed, see ldpc_param_code.
      */
+    ldpc_code_t *code;
     ldpc_ll_matrix_t *h_matrix;
 
     unsigned short max_iter; /* Maximum number of LDPC decoder iterations */
-    unsigned short num_threads; /* Number of simulataneous active worker threads */
+    unsigned short num_threads; /* Number of simulataneous active worker threads, 0 to decode on the calling thread */
+    /* Check the parity after every iteration and stop when all codewords are valid. The
+     * hard decisions of a codeword that passed the last check are returned as checked.
+     * Soft output, and the codewords that did not pass, are taken from one more bit node
+     * update, and the status is checked on those decisions.
+     */
+    unsigned char early_termination;
+    /* For early termination, take the parity of each check from the signs of its incoming
+     * messages during the check node update, instead of gathering the hard decisions of
+     * the bit node update. Each iteration is cheaper, but the messages are extrinsic and
+     * their signs settle later than the hard decisions, so codewords are detected some
+     * iterations later. No hard decisions are checked during the iterations, so all of
+     * them come from one more bit node update, and the status is checked on those.
+     * Not used by ldpc_decode_stream.
+     */
+    unsigned char sign_parity;
+    /* Bit nodes ahead of the one being updated whose edge messages the bit node update
+     * prefetches, 0 disables the prefetch. The edges of a bit node are scattered over the
+     * message array, so the hardware prefetcher cannot follow them.
+     */
+    unsigned short prefetch_distance;
+
+    ldpc_algorithm_t algorithm; /* Check node update rule, see ldpc_algorithm_t */
+    unsigned char offset; /* Offset (beta) for LDPC_OFFSET_MIN_SUM, in quantized LLR units */
+    float alpha; /* Scaling factor (0 < alpha <= 1) for LDPC_NORMALIZED_MIN_SUM */
+    ldpc_precision_t precision; /* Internal message width, see ldpc_precision_t */
+    ldpc_reorder_t reorder; /* Node renumbering for memory locality, see ldpc_reorder_t */
+
+    /* Quantization of float LLRs, used by ldpc_decode_float */
+    ldpc_llr_scaling_t llr_scaling;
+    float llr_scale; /* Quantization steps per LLR unit for LDPC_LLR_SCALE_FIXED */
+    float llr_target; /* Target mean quantized magnitude for LDPC_LLR_SCALE_ADAPTIVE */
+
+    /* Soft output of ldpc_decode_soft */
+    ldpc_soft_output_t soft_output;
+    unsigned char soft_output_parity; /* Output all N bits if set, otherwise only the K data bits */
+
+    /* Hard-decision bit-flipping stage run before min-sum. Only the codewords it
+     * cannot correct are decoded with min-sum. Not used by ldpc_decode_soft.
+     */
+    unsigned short bf_max_iter; /* Bit-flipping iterations, 0 disables the stage */
+    unsigned char bf_threshold; /* Channel LLRs with a smaller magnitude are unreliable and flipped more easily */
+
+    /* Shortened and punctured bits, as column indices of H. Shortened bits are known
+     * to be zero: they are not part of the decoder input or output, and are removed
+     * from the graph. Punctured bits are not part of the input but are decoded, from
+     * an LLR of zero. The input of each codeword holds the remaining bits in the order
+     * of H, and the output the bits that are not shortened. See ldpc_decoder_input_size.
+     * The arrays are only read by ldpc_init.
+     */
+    int *shortened;
+    int num_shortened;
+    int *punctured;
+    int num_punctured;
+
+    /* Bounds on the decoding of each batch, 0 disables them. The decoder stops iterating
+     * at the deadline, or when the iteration budget is used up, and the codewords that
+     * are not valid by then are reported as cut off, see ldpc_status_t. Iterations
+     * saved by batches converging early (see early_termination) are left for later
+     * batches, up to iter_budget_max. max_iter still bounds every batch.
+     */
+    unsigned int deadline_us; /* Wall-clock time from the start of a decode call */
+    unsigned int iter_budget; /* Iterations granted per batch */
+    unsigned int iter_budget_max; /* Iterations that can be saved, 0 for max_iter */
+
+    /* Directory on local disk caching the decoder's tables, or NULL. The tables derived
+     * from the code, reorder, shortened and punctured are built once and stored there,
+     * and later ldpc_init calls with the same inputs map them instead, see cache.h.
+     */
+    const char *cache_dir;
 
 } ldpc_param_t;
 
@@ -66,18 +253,126 @@ ldpc_t* (*ldpc_init)(ldpc_param_t *param);
  * Decode one batch of codewords.
  * As of now, this takes a batch of 128 encoded codewords (soft-bits, 8-bit value per bit), and produces
  * 128 decoded codewords in bitval (memory for bitval must be allocated).
+ * Returns the number of decoded codewords that satisfy all parity checks.
+ * The same holds for the other decode functions below.
  */
 int (*ldpc_decode)(ldpc_t *h, char *llr_in, unsigned char *bitval);
 
+/*
+ * Decode one batch of codewords given as float LLRs (positive means a zero bit),
+ * in the same layout as for ldpc_decode.
+ * The LLRs are scaled and saturated to the decoder's internal format while interleaving.
+ * frame_scale can point to 128 per-codeword scale factors, overriding the
+ * llr_scaling policy of the decoder parameters. Pass NULL to use the policy.
+ */
+int (*ldpc_decode_float)(ldpc_t *h, float *llr_in, float *frame_scale, unsigned char *bitval);
+
+/* Narrowest LLR width accepted by ldpc_decode_packed */
+#define LDPC_PACKED_MIN_BITS 4
+
+/*
+ * Decode one batch of codewords given as packed LLRs of bits bits each (4 to 8), for
+ * less memory and IPC traffic than one byte per LLR. Each LLR is a two's complement
+ * value, packed least significant bit first from the low bits of the first byte, and
+ * each codeword starts at a byte boundary, see ldpc_llr_pack. The codewords are in the
+ * order of ldpc_decode, ldpc_decoder_packed_input_size(h, bits)/128 bytes each.
+ * Returns -1 for an unsupported width.
+ */
+int (*ldpc_decode_packed)(ldpc_t *h, unsigned char *llr_in, int bits, unsigned char *bitval);
+
+/*
+ * Decode one batch of codewords and produce soft output instead of hard decisions.
+ * llr_out receives, for each of the 128 codewords, saturated 8-bit a-posteriori or extrinsic
+ * LLRs (see soft_output in ldpc_param_t) in the same quantized units as the input.
+ * The output holds all bits (soft_output_parity set) or the data bits of each codeword,
+ * except for shortened bits, see ldpc_decoder_soft_output_size.
+ */
+int (*ldpc_decode_soft)(ldpc_t *h, char *llr_in, char *llr_out);
+
+/*
+ * Decode a stream of codewords continuously instead of in batches. Each block of 16
+ * codewords of the batch is retired as soon as all of them satisfy the parity checks,
+ * or after max_iter iterations, and is refilled with the next frames while the other
+ * blocks keep iterating, so the throughput follows the average number of iterations
+ * rather than the worst case of each batch.
+ * next is called for each new frame, to fill llr with the ldpc_decoder_input_size(h)/128
+ * LLRs of a codeword, and returns 0 once the stream has ended. done is called for each
+ * decoded frame with its ldpc_decoder_output_size(h)/128 hard decisions and its status.
+ * Frames are numbered from 0 in the order of the next calls, and completed out of order.
+ * The bit-flipping stage, deadline and iteration budget are not used.
+ * Returns the number of frames decoded, or -1 if the decoder uses LDPC_PRECISION_16.
+ */
+long (*ldpc_decode_stream)(ldpc_t *h, int (*next)(void *ctx, char *llr),
+                           void (*done)(void *ctx, long frame, const unsigned char *bitval, const ldpc_status_t *status), void *ctx);
+
 /*
  * Free decoder resources
  */
 void (*ldpc_destroy)(ldpc_t *h);
 
+/*
+ * Get the status (parity check result and iterations) of each of the 128 codewords
+ * of the last decoded batch. Returns the number of valid codewords.
+ */
+int (*ldpc_decoder_status)(ldpc_t *h, ldpc_status_t *status);
+
+/*
+ * Get the statistics of the decoder. The counters are updated by the decode functions
+ * and should not be read while a decode call on the same decoder is running.
+ */
+void (*ldpc_decoder_stats)(ldpc_t *h, ldpc_stats_t *stats);
+
+/* Clear the statistics of the decoder */
+void (*ldpc_decoder_stats_reset)(ldpc_t *h);
+
+/*
+ * Set an absolute CLOCK_MONOTONIC deadline for the next decode call, instead of
+ * the deadline_us of the decoder parameters. NULL clears a deadline not yet used.
+ */
+void (*ldpc_decoder_set_deadline)(ldpc_t *h, const struct timespec *deadline);
+
+/* Give the number of worker threads of the decoder, or 0 if it decodes on the calling thread */
+int (*ldpc_decoder_num_threads)(ldpc_t *h);
+
 /* Give the required size of the input LLR array required by the decoder */
 size_t (*ldpc_decoder_input_size)(ldpc_t *h);
+/* Give the required size of the packed input array of ldpc_decode_packed */
+size_t (*ldpc_decoder_packed_input_size)(ldpc_t *h, int bits);
 /* Give the required size of the output buffer */
 size_t (*ldpc_decoder_output_size)(ldpc_t *h);
+/* Give the required size of the soft output buffer of ldpc_decode_soft */
+size_t (*ldpc_decoder_soft_output_size)(ldpc_t *h);
+
+/********************
+ * Decoder engine
+*********************/
+
+/*
+ * An engine decodes batches of several codes, such as the MODCODs of an adaptive
+ * coding stream, with one set of worker threads and one scratch memory area sized
+ * for the largest code. Switching codes between batches costs nothing.
+ * The engine and its codes must not be used by several threads at once.
+ */
+ldpc_engine_t *(*ldpc_engine_init)(unsigned short num_threads);
+
+/*
+ * Register a code, initialized from param like ldpc_init, except that num_threads is
+ * the engine's. Returns the ID of the code (0 for the first code, 1 for the next and so on),
+ * or -1 on failure.
+ */
+int (*ldpc_engine_add_code)(ldpc_engine_t *e, ldpc_param_t *param);
+
+/*
+ * The decoder of a registered code, for the decoder functions above, or NULL for an
+ * unknown ID. It is freed by ldpc_engine_destroy, not by ldpc_destroy.
+ */
+ldpc_t *(*ldpc_engine_code)(ldpc_engine_t *e, int code);
+
+/* Decode one batch of the given code, see ldpc_decode. Returns -1 for an unknown ID. */
+int (*ldpc_engine_decode)(ldpc_engine_t *e, int code, char *llr_in, unsigned char *bitval);
+
+/* Free the engine and all its codes */
+void (*ldpc_engine_destroy)(ldpc_engine_t *e);
 
 /*******************
  * Encoder functions
@@ -92,4 +387,22 @@ void ldpc_ll_matrix_destroy(ldpc_ll_matrix_t *H);
 void ldpc_param_init(ldpc_param_t *param);
 void ldpc_param_destroy(ldpc_param_t *param);
 
+/* Build the compact form of H. Returns NULL on failure. */
+ldpc_code_t *ldpc_code_create(const ldpc_ll_matrix_t *H);
+void ldpc_code_destroy(ldpc_code_t *code);
+
+/* The compact H matrix of param, built from h_matrix if not yet set. Not safe to call
+ * from several threads on the same param until the compact form exists.
+ * Returns NULL if param has no matrix.
+ */
+ldpc_code_t *ldpc_param_code(ldpc_param_t *param);
+
+/* Build the compact H matrix of param and free its linked-list form.
+ * Returns 0 on success and -1 otherwise.
+ */
+int ldpc_param_compact(ldpc_param_t *param);
+
+/* Pack len 8-bit LLRs to bits bits each, saturated, in the layout of ldpc_decode_packed */
+void ldpc_llr_pack(const char *llr, int len, int bits, unsigned char *packed);
+
 #endif //LDPC_H
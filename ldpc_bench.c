@@ -0,0 +1,415 @@
+/*****************************************************************
+    Decoder throughput benchmark across codes, thread counts,
+    iteration counts, batch counts and decoder backends.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#include "ldpc.h"
+#include "alist.h"
+#include "channel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <glob.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define BATCH 128
+#define MAX_LIST 16
+
+/* Decoder backends that can be benchmarked */
+typedef struct {
+    const char *name;
+    ldpc_precision_t precision;
+    ldpc_algorithm_t algorithm;
+} bench_backend_t;
+
+static const bench_backend_t backends[] = {
+    { "sse8-ms", LDPC_PRECISION_8, LDPC_MIN_SUM },
+    { "sse8-oms", LDPC_PRECISION_8, LDPC_OFFSET_MIN_SUM },
+    { "sse8-nms", LDPC_PRECISION_8, LDPC_NORMALIZED_MIN_SUM },
+    { "sse16-ms", LDPC_PRECISION_16, LDPC_MIN_SUM },
+    { "sse16-oms", LDPC_PRECISION_16, LDPC_OFFSET_MIN_SUM },
+    { "sse16-nms", LDPC_PRECISION_16, LDPC_NORMALIZED_MIN_SUM },
+};
+#define NUM_BACKENDS ((int)(sizeof(backends)/sizeof(backends[0])))
+
+static const char *reorder_names[] = { "none", "degree", "rcm" };
+#define NUM_REORDER ((int)(sizeof(reorder_names)/sizeof(reorder_names[0])))
+
+/* Last level cache references (which approximate L2 misses) and misses,
+ * counted for the benchmark and the decoder threads it creates
+ */
+typedef struct {
+    int fd[2];
+    long long count[2];
+} bench_counters_t;
+
+static void counters_open(bench_counters_t *c) {
+    struct perf_event_attr attr;
+    const unsigned long long config[2] = { PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES };
+
+    for (int i = 0; i < 2; i++) {
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config[i];
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        c->fd[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        c->count[i] = 0;
+    }
+}
+
+static void counters_start(bench_counters_t *c) {
+    for (int i = 0; i < 2; i++)
+        if (c->fd[i] >= 0) {
+            ioctl(c->fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(c->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+}
+
+static void counters_stop(bench_counters_t *c) {
+    long long v;
+
+    for (int i = 0; i < 2; i++)
+        if (c->fd[i] >= 0) {
+            ioctl(c->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(c->fd[i], &v, sizeof(v)) == sizeof(v))
+                c->count[i] += v;
+        }
+}
+
+static void counters_close(bench_counters_t *c) {
+    for (int i = 0; i < 2; i++)
+        if (c->fd[i] >= 0)
+            close(c->fd[i]);
+}
+
+/* Counter value per frame as a CSV field, empty if the counter is not available */
+static void counters_print(FILE *out, bench_counters_t *c, int i, long frames) {
+    if (c->fd[i] >= 0)
+        fprintf(out, ",%.1f", (double)c->count[i] / frames);
+    else
+        fprintf(out, ",");
+}
+
+/* Number of check nodes and bit nodes of each degree, binned as in ldpc_stats_t */
+static void degree_histogram(ldpc_code_t *H, long *cn_nodes, long *bn_nodes) {
+    int i, deg;
+
+    memset(cn_nodes, 0, LDPC_STATS_MAX_DEGREE*sizeof(long));
+    memset(bn_nodes, 0, LDPC_STATS_MAX_DEGREE*sizeof(long));
+    for (i = 0; i < H->M; i++) {
+        deg = H->row_start[i + 1] - H->row_start[i];
+        cn_nodes[deg < LDPC_STATS_MAX_DEGREE ? deg : LDPC_STATS_MAX_DEGREE - 1]++;
+    }
+    for (i = 0; i < H->N; i++) {
+        deg = H->col_start[i + 1] - H->col_start[i];
+        bn_nodes[deg < LDPC_STATS_MAX_DEGREE ? deg : LDPC_STATS_MAX_DEGREE - 1]++;
+    }
+}
+
+/* Node update cycles by degree. updates is the number of times each node was updated
+ * for a whole batch, and the cycles are given per node update and per edge and frame.
+ */
+static void degree_print(FILE *out, const char *prefix, const char *kind, const long *nodes,
+                         const unsigned long long *cycles, long updates) {
+    double per_node;
+
+    for (int d = 1; d < LDPC_STATS_MAX_DEGREE; d++) {
+        if (!nodes[d])
+            continue;
+        per_node = (double)cycles[d] / updates / nodes[d];
+        fprintf(out, "%s,%s,%d,%ld,%.1f,%.3f\n", prefix, kind, d, nodes[d], per_node, per_node / d / BATCH);
+    }
+}
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* Parse a comma separated list of integers */
+static int parse_list(const char *s, int *list) {
+    int n = 0;
+    char *end;
+
+    while (*s && n < MAX_LIST) {
+        list[n++] = (int)strtol(s, &end, 10);
+        if (*end != ',')
+            break;
+        s = end + 1;
+    }
+    return n;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Percentile (0..1) of sorted samples, nearest rank */
+static double percentile(const double *sorted, int n, double q) {
+    return sorted[(int)floor(q*(n - 1) + 0.5)];
+}
+
+/* Quantized channel LLRs for one batch, in the decoder's input format */
+static char *make_input(ldpc_param_t *param, float ebn0) {
+    ldpc_code_t *H = param->code;
+    char *input = (char *)malloc(BATCH*H->K*sizeof(char));
+    char *enc = (char *)malloc(BATCH*H->N*sizeof(char));
+    float *llr = (float *)malloc(BATCH*H->N*sizeof(float));
+    char *chan = (char *)malloc(BATCH*H->N*sizeof(char));
+    channel_rng_t rng;
+    int i;
+
+    channel_rng_init(&rng, 1, 0);
+    channel_random_bits(&rng, input, BATCH*H->K);
+    for (i = 0; i < BATCH; i++)
+        ldpc_encode(param, H->K, input + i*H->K, enc + i*H->N);
+    channel_awgn_bpsk(&rng, enc, BATCH*H->N, channel_sigma(ebn0, (float)H->K / H->N), llr);
+    for (i = 0; i < BATCH*H->N; i++)
+        chan[i] = (char)fmaxf(-127.0f, fminf(127.0f, rintf(llr[i]*param->llr_scale)));
+
+    free(input);
+    free(enc);
+    free(llr);
+    return chan;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "Usage: %s [options] [matrix.alist ...]\n"
+        "  Without matrices, all of matrices/*.alist are benchmarked.\n"
+        "  -t list      Decoder thread counts (default 1)\n"
+        "  -i list      Iteration counts (default 30)\n"
+        "  -b list      Batches of 128 frames per timed sample (default 1)\n"
+        "  -p list      Bit node prefetch distances (default 4)\n"
+        "  -B list      Backends, comma separated, or \"all\" (default sse8-ms)\n"
+        "  -R list      Node orderings: none, degree, rcm, or \"all\" (default none)\n"
+        "  -w n         Warm-up samples (default 1)\n"
+        "  -r n         Timed samples (default 5)\n"
+        "  -E ebn0      Eb/N0 of the input frames in dB (default 10)\n"
+        "  -F iter      Bit-flipping iterations before min-sum (default 0, disabled),\n"
+        "               leaves edges_per_s empty\n"
+        "  -o file      Write CSV to file instead of stdout\n"
+        "  -D file      Write node update cycles by node degree as CSV to file\n"
+        "Backends:", prog);
+    for (int i = 0; i < NUM_BACKENDS; i++)
+        fprintf(stderr, " %s", backends[i].name);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv) {
+    int threads[MAX_LIST] = { 1 }, num_threads = 1;
+    int iters[MAX_LIST] = { 30 }, num_iters = 1;
+    int batches[MAX_LIST] = { 1 }, num_batches = 1;
+    int prefetch[MAX_LIST] = { 4 }, num_prefetch = 1;
+    int use_backend[NUM_BACKENDS] = { 1 };
+    int use_reorder[NUM_REORDER] = { 1 };
+    bench_counters_t counters;
+    int warmup = 1, reps = 5;
+    float ebn0 = 10.0f;
+    int bf_iter = 0;
+    FILE *out = stdout, *deg_out = NULL;
+    long cn_nodes[LDPC_STATS_MAX_DEGREE], bn_nodes[LDPC_STATS_MAX_DEGREE];
+    ldpc_stats_t stats;
+    char prefix[512];
+    glob_t g;
+    char **matrices;
+    int num_matrices;
+    int c, m, b, o, t, i, pf, nb, r;
+
+    while ((c = getopt(argc, argv, "t:i:b:p:B:R:w:r:E:F:o:D:h")) != -1) {
+        switch (c) {
+        case 't': num_threads = parse_list(optarg, threads); break;
+        case 'i': num_iters = parse_list(optarg, iters); break;
+        case 'b': num_batches = parse_list(optarg, batches); break;
+        case 'p': num_prefetch = parse_list(optarg, prefetch); break;
+        case 'B':
+            for (b = 0; b < NUM_BACKENDS; b++)
+                use_backend[b] = !strcmp(optarg, "all");
+            for (char *tok = strtok(optarg, ","); tok; tok = strtok(NULL, ","))
+                for (b = 0; b < NUM_BACKENDS; b++)
+                    if (!strcmp(tok, backends[b].name))
+                        use_backend[b] = 1;
+            break;
+        case 'R':
+            for (b = 0; b < NUM_REORDER; b++)
+                use_reorder[b] = !strcmp(optarg, "all");
+            for (char *tok = strtok(optarg, ","); tok; tok = strtok(NULL, ","))
+                for (b = 0; b < NUM_REORDER; b++)
+                    if (!strcmp(tok, reorder_names[b]))
+                        use_reorder[b] = 1;
+            break;
+        case 'w': warmup = atoi(optarg); break;
+        case 'r': reps = atoi(optarg); break;
+        case 'E': ebn0 = atof(optarg); break;
+        case 'F': bf_iter = atoi(optarg); break;
+        case 'o':
+            if (!(out = fopen(optarg, "w"))) {
+                fprintf(stderr, "Error opening output file %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'D':
+            if (!(deg_out = fopen(optarg, "w"))) {
+                fprintf(stderr, "Error opening output file %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (reps < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    memset(&g, 0, sizeof(g));
+    if (optind < argc) {
+        matrices = argv + optind;
+        num_matrices = argc - optind;
+    } else {
+        glob("matrices/*.alist", 0, NULL, &g);
+        matrices = g.gl_pathv;
+        num_matrices = (int)g.gl_pathc;
+    }
+
+    double *samples = (double *)malloc(reps*sizeof(double));
+    counters_open(&counters);
+
+    fprintf(out, "matrix,backend,reorder,threads,iterations,prefetch,batches,frames,median_ms,p10_ms,p90_ms,mbps,edges_per_s,ns_per_frame,"
+                 "llc_refs_per_frame,llc_misses_per_frame\n");
+    if (deg_out)
+        fprintf(deg_out, "matrix,backend,reorder,threads,iterations,prefetch,batches,node,degree,nodes,cycles_per_node,cycles_per_edge\n");
+
+    for (m = 0; m < num_matrices; m++) {
+        ldpc_param_t param;
+        ldpc_code_t *H = ldpc_alist_load(matrices[m]);
+        if (!H)
+            continue;
+
+        ldpc_param_init(&param);
+        param.code = H;
+        /* Fixed iteration counts make the samples comparable */
+        param.early_termination = 0;
+        param.bf_max_iter = bf_iter;
+
+        degree_histogram(H, cn_nodes, bn_nodes);
+        char *chan = make_input(&param, ebn0);
+        unsigned char *dec = (unsigned char *)malloc(BATCH*H->K*sizeof(unsigned char));
+
+        for (b = 0; b < NUM_BACKENDS; b++) {
+            if (!use_backend[b])
+                continue;
+            for (o = 0; o < NUM_REORDER; o++) {
+                if (!use_reorder[o])
+                    continue;
+                for (t = 0; t < num_threads; t++) {
+                    for (i = 0; i < num_iters; i++) {
+                        for (pf = 0; pf < num_prefetch; pf++) {
+                            param.precision = backends[b].precision;
+                            param.algorithm = backends[b].algorithm;
+                            param.reorder = (ldpc_reorder_t)o;
+                            param.num_threads = threads[t];
+                            param.max_iter = iters[i];
+                            param.prefetch_distance = prefetch[pf];
+
+                            ldpc_t *decoder = ldpc_init(&param);
+                            if (!decoder)
+                                continue;
+
+                            for (nb = 0; nb < num_batches; nb++) {
+                                for (r = 0; r < warmup; r++)
+                                    ldpc_decode(decoder, chan, dec);
+
+                                ldpc_decoder_stats_reset(decoder);
+                                counters.count[0] = counters.count[1] = 0;
+                                for (r = 0; r < reps; r++) {
+                                    counters_start(&counters);
+                                    double t0 = now();
+                                    for (int k = 0; k < batches[nb]; k++)
+                                        ldpc_decode(decoder, chan, dec);
+                                    samples[r] = now() - t0;
+                                    counters_stop(&counters);
+                                }
+                                qsort(samples, reps, sizeof(double), cmp_double);
+
+                                double med = percentile(samples, reps, 0.5);
+                                long frames = (long)BATCH*batches[nb];
+
+                                fprintf(out, "%s,%s,%s,%d,%d,%d,%d,%ld,%.3f,%.3f,%.3f,%.3f,",
+                                        matrices[m], backends[b].name, reorder_names[o], threads[t], iters[i], prefetch[pf], batches[nb], frames,
+                                        med*1e3, percentile(samples, reps, 0.1)*1e3, percentile(samples, reps, 0.9)*1e3,
+                                        (double)frames*H->K / med / 1e6);
+                                /* With bit-flipping, min-sum does not visit every edge of every frame */
+                                if (!bf_iter)
+                                    fprintf(out, "%.4e", (double)frames*H->num_edges*iters[i] / med);
+                                fprintf(out, ",%.1f", med*1e9 / frames);
+                                counters_print(out, &counters, 0, frames*reps);
+                                counters_print(out, &counters, 1, frames*reps);
+                                fprintf(out, "\n");
+                                fflush(out);
+
+                                if (deg_out) {
+                                    ldpc_decoder_stats(decoder, &stats);
+                                    snprintf(prefix, sizeof(prefix), "%s,%s,%s,%d,%d,%d,%d", matrices[m], backends[b].name,
+                                             reorder_names[o], threads[t], iters[i], prefetch[pf], batches[nb]);
+                                    degree_print(deg_out, prefix, "cn", cn_nodes, stats.cn_degree_cycles, (long)iters[i]*batches[nb]*reps);
+                                    degree_print(deg_out, prefix, "bn", bn_nodes, stats.bn_degree_cycles, (long)iters[i]*batches[nb]*reps);
+                                    fflush(deg_out);
+                                }
+                            }
+
+                            ldpc_destroy(decoder);
+                        }
+                    }
+                }
+            }
+        }
+
+        free(chan);
+        free(dec);
+        ldpc_param_destroy(&param);
+    }
+
+    free(samples);
+    counters_close(&counters);
+    if (g.gl_pathc)
+        globfree(&g);
+    if (out != stdout)
+        fclose(out);
+    if (deg_out)
+        fclose(deg_out);
+
+    return 0;
+}
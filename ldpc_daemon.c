@@ -0,0 +1,218 @@
+/*****************************************************************
+    Decoding service for clients in other processes. The daemon owns
+    one decoder, and batches are passed through shared memory rings,
+    see ldpc_shm.h.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#define _GNU_SOURCE
+#include "ldpc.h"
+#include "alist.h"
+#include "ldpc_shm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <x86intrin.h>
+
+/* Create the shared memory of a client, and send it over the socket. The layout is
+ * returned in hdr, which the daemon keeps: the client can write to the header in the
+ * shared memory. Returns the mapped memory, or NULL on failure.
+ */
+static void *daemon_setup_client(int sock, ldpc_t *decoder, int num_slots, ldpc_shm_header_t *hdr) {
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    char buf[CMSG_SPACE(sizeof(int))];
+    char byte = 0;
+    size_t size;
+    void *mem;
+    int fd;
+
+    size = ldpc_shm_layout(hdr, num_slots, ldpc_decoder_input_size(decoder), ldpc_decoder_output_size(decoder));
+    fd = memfd_create("ldpc", MFD_CLOEXEC);
+    if (fd < 0 || ftruncate(fd, size)) {
+        fprintf(stderr, "Error creating %zu bytes of shared memory\n", size);
+        if (fd >= 0)
+            close(fd);
+        return NULL;
+    }
+    mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    /* The memory starts out zeroed, so the rings are empty */
+    memcpy(mem, hdr, sizeof(*hdr));
+
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = buf;
+    msg.msg_controllen = sizeof(buf);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    if (sendmsg(sock, &msg, 0) != 1) {
+        fprintf(stderr, "Error sending the shared memory to the client\n");
+        munmap(mem, size);
+        mem = NULL;
+    }
+    close(fd);
+
+    return mem;
+}
+
+/* Decode the batches of one client until it disconnects. The rings and slots are found
+ * from the daemon's copy hdr of the layout, never from the header in the shared memory.
+ */
+static void daemon_serve(int sock, ldpc_t *decoder, const ldpc_shm_header_t *hdr, void *mem) {
+    ldpc_shm_ring_t *sq = ldpc_shm_sq(hdr, mem);
+    ldpc_shm_ring_t *cq = ldpc_shm_cq(hdr, mem);
+    const struct timespec nap = { 0, 50000 };
+    struct pollfd pfd = { sock, POLLIN, 0 };
+    ldpc_shm_result_t *result;
+    long spin = 0;
+    int slot;
+
+    for (;;) {
+        slot = ldpc_shm_ring_pop(sq, hdr->num_slots);
+        if (slot < 0) {
+            if (spin++ < LDPC_SHM_SPIN) {
+                _mm_pause();
+                continue;
+            }
+            /* Idle for a while: sleep between polls, and notice if the client is gone */
+            if (poll(&pfd, 1, 0) > 0)
+                return;
+            nanosleep(&nap, NULL);
+            continue;
+        }
+        spin = 0;
+
+        if (slot >= (int)hdr->num_slots) {
+            fprintf(stderr, "Client submitted invalid slot %d, disconnecting\n", slot);
+            return;
+        }
+        result = ldpc_shm_slot_result(hdr, mem, slot);
+        result->num_valid = ldpc_decode(decoder, ldpc_shm_slot_input(hdr, mem, slot), ldpc_shm_slot_output(hdr, mem, slot));
+        ldpc_decoder_status(decoder, result->status);
+        ldpc_shm_ring_push(cq, hdr->num_slots, slot);
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "Usage: %s -m matrix.alist -s socket [options]\n"
+        "  -n slots     Batch slots per client, rounded up to a power of two (default 8)\n"
+        "  -t threads   Decoder worker threads (default 1)\n"
+        "  -i iter      Maximum number of iterations (default 30)\n"
+        "  -a alg       Check node rule: ms, oms or nms (default ms)\n"
+        "  -p bits      Message precision: 8 or 16 (default 8)\n"
+        "  -C dir       Cache the code and decoder tables in dir for faster restarts\n", prog);
+}
+
+int main(int argc, char **argv) {
+    ldpc_param_t param;
+    ldpc_t *decoder;
+    char *matrix = NULL, *path = NULL;
+    struct sockaddr_un addr;
+    int num_slots = 8, slots;
+    int c, sock, client;
+    ldpc_shm_header_t hdr;
+    void *mem;
+
+    ldpc_param_init(&param);
+    param.num_threads = 1;
+
+    while ((c = getopt(argc, argv, "m:s:n:t:i:a:p:C:h")) != -1) {
+        switch (c) {
+        case 'm': matrix = optarg; break;
+        case 's': path = optarg; break;
+        case 'n': num_slots = atoi(optarg); break;
+        case 't': param.num_threads = atoi(optarg); break;
+        case 'i': param.max_iter = atoi(optarg); break;
+        case 'a':
+            if (!strcmp(optarg, "oms"))
+                param.algorithm = LDPC_OFFSET_MIN_SUM;
+            else if (!strcmp(optarg, "nms"))
+                param.algorithm = LDPC_NORMALIZED_MIN_SUM;
+            else
+                param.algorithm = LDPC_MIN_SUM;
+            break;
+        case 'p': param.precision = atoi(optarg) == 16 ? LDPC_PRECISION_16 : LDPC_PRECISION_8; break;
+        case 'C': param.cache_dir = optarg; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!matrix || !path || num_slots < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    for (slots = 1; slots < num_slots; slots *= 2);
+
+    param.code = ldpc_alist_load_cached(matrix, param.cache_dir);
+    if (!param.code)
+        return 1;
+    decoder = ldpc_init(&param);
+    if (!decoder)
+        return 1;
+
+    signal(SIGPIPE, SIG_IGN);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+    sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0 || bind(sock, (struct sockaddr *)&addr, sizeof(addr)) || listen(sock, 1)) {
+        fprintf(stderr, "Error listening on %s\n", path);
+        return 1;
+    }
+    fprintf(stderr, "Decoding %s on %s with %d slots\n", matrix, path, slots);
+
+    /* One client at a time */
+    for (;;) {
+        client = accept(sock, NULL, NULL);
+        if (client < 0)
+            continue;
+        mem = daemon_setup_client(client, decoder, slots, &hdr);
+        if (mem) {
+            daemon_serve(client, decoder, &hdr, mem);
+            munmap(mem, hdr.total_size);
+        }
+        close(client);
+    }
+
+    return 0;
+}
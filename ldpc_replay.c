@@ -0,0 +1,296 @@
+/*****************************************************************
+    Differential replay of LLR batches through the SIMD decoder and
+    the scalar reference decoder.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#include "ldpc.h"
+#include "alist.h"
+#include "channel.h"
+#include "ref.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <unistd.h>
+
+#define BATCH 128
+
+/* Paired failures beyond this many standard deviations fail the statistical comparison */
+#define REPLAY_MAX_Z 3.0
+
+typedef struct {
+    long batches;
+    long frames;
+    /* Bit-exact comparison */
+    long hard_mismatch; /* Codewords with different hard decisions */
+    long soft_mismatch; /* Codewords with different soft output */
+    long status_mismatch; /* Codewords with a different status */
+    /* Statistical comparison */
+    long dec_failed; /* Codewords not valid after the SIMD decoder */
+    long ref_failed; /* Codewords not valid after the reference decoder */
+    long dec_only; /* Codewords only the SIMD decoder failed on */
+    long ref_only; /* Codewords only the reference decoder failed on */
+    long dec_iterations;
+    long ref_iterations;
+} replay_result_t;
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "Usage: %s -m matrix.alist [options]\n"
+        "  Decodes seeded batches with ldpc_decode and with the reference decoder in the same\n"
+        "  integer arithmetic, and reports any codeword whose output differs.\n"
+        "  -n batches   Batches of 128 frames to replay (default 10, or all batches of the file with -r)\n"
+        "  -E ebn0      Eb/N0 of the generated frames in dB (default 1.5)\n"
+        "  -S seed      Random seed, batch b uses stream b (default 1)\n"
+        "  -t threads   Worker threads of the decoder, 0 for the calling thread (default 1)\n"
+        "  -i iter      Maximum number of iterations (default 30)\n"
+        "  -a alg       Check node rule: ms, oms or nms (default ms)\n"
+        "  -p bits      Message precision: 8 or 16 (default 8)\n"
+        "  -q scale     LLR quantization scale (default 4)\n"
+        "  -k           No early termination\n"
+        "  -x           Extrinsic soft output\n"
+        "  -s           Compare only the failure rates, for kernels not meant to be bit-exact\n"
+        "  -f           Compare the failure rates against the float reference on the unquantized LLRs\n"
+        "  -r file      Replay the batches of file, raw 8-bit LLRs as taken by ldpc_decode\n"
+        "  -w file      Write the batches with a mismatch to file, for -r\n", prog);
+}
+
+/* Frames of batch b: encoded random data over the AWGN channel, as LLRs scaled by llr_scale */
+static void replay_generate(ldpc_param_t *param, uint64_t seed, long b, float ebn0, char *in, char *enc, float *llr) {
+    ldpc_code_t *H = param->code;
+    channel_rng_t rng;
+
+    channel_rng_init(&rng, seed, (uint32_t)b);
+    channel_random_bits(&rng, in, BATCH*H->K);
+    for (int cw = 0; cw < BATCH; cw++)
+        ldpc_encode(param, H->K, in + cw*H->K, enc + cw*H->N);
+    channel_awgn_bpsk(&rng, enc, BATCH*H->N, channel_sigma(ebn0, (float)H->K/H->N), llr);
+    for (int i = 0; i < BATCH*H->N; i++)
+        llr[i] *= param->llr_scale;
+}
+
+int main(int argc, char **argv) {
+    ldpc_code_t *H;
+    ldpc_param_t param;
+    ldpc_t *decoder;
+    ldpc_ref_t *ref;
+    ldpc_stats_t stats;
+    ldpc_status_t status[BATCH], ref_status;
+    replay_result_t res;
+    char *matrix = NULL;
+    FILE *in_file = NULL, *out_file = NULL;
+    long num_batches = 0;
+    float ebn0 = 1.5f;
+    uint64_t seed = 1;
+    int statistical = 0, use_float = 0;
+    int c, cw, i, n, k, soft_len, mismatch;
+    unsigned long long iterations;
+
+    ldpc_param_init(&param);
+
+    while ((c = getopt(argc, argv, "m:n:E:S:t:i:a:p:q:kxsfr:w:h")) != -1) {
+        switch (c) {
+        case 'm': matrix = optarg; break;
+        case 'n': num_batches = atol(optarg); break;
+        case 'E': ebn0 = atof(optarg); break;
+        case 'S': seed = strtoull(optarg, NULL, 0); break;
+        case 't': param.num_threads = atoi(optarg); break;
+        case 'i': param.max_iter = atoi(optarg); break;
+        case 'a':
+            if (!strcmp(optarg, "oms"))
+                param.algorithm = LDPC_OFFSET_MIN_SUM;
+            else if (!strcmp(optarg, "nms"))
+                param.algorithm = LDPC_NORMALIZED_MIN_SUM;
+            else
+                param.algorithm = LDPC_MIN_SUM;
+            break;
+        case 'p': param.precision = atoi(optarg) == 16 ? LDPC_PRECISION_16 : LDPC_PRECISION_8; break;
+        case 'q': param.llr_scale = atof(optarg); break;
+        case 'k': param.early_termination = 0; break;
+        case 'x': param.soft_output = LDPC_SOFT_EXTRINSIC; break;
+        case 's': statistical = 1; break;
+        case 'f': statistical = use_float = 1; break;
+        case 'r':
+            if (!(in_file = fopen(optarg, "rb"))) {
+                fprintf(stderr, "Error opening input file %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'w':
+            if (!(out_file = fopen(optarg, "wb"))) {
+                fprintf(stderr, "Error opening output file %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!matrix || num_batches < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (!num_batches)
+        num_batches = in_file ? LONG_MAX : 10;
+
+    H = ldpc_alist_load(matrix);
+    if (!H)
+        return 1;
+    param.code = H;
+
+    decoder = ldpc_init(&param);
+    if (!decoder)
+        return 1;
+    ref = ldpc_ref_create(&param, use_float ? LDPC_REF_FLOAT :
+                          param.precision == LDPC_PRECISION_16 ? LDPC_REF_INT16 : LDPC_REF_INT8);
+    if (!ref)
+        return 1;
+
+    n = H->N;
+    k = ldpc_decoder_output_size(decoder)/BATCH;
+    soft_len = ldpc_decoder_soft_output_size(decoder)/BATCH;
+    char *in = (char *)malloc(BATCH*H->K);
+    char *enc = (char *)malloc(BATCH*n);
+    float *llr = (float *)malloc(BATCH*n*sizeof(float));
+    char *chan = (char *)malloc(BATCH*n);
+    unsigned char *dec = (unsigned char *)malloc(BATCH*k);
+    char *soft = (char *)malloc(BATCH*soft_len);
+    float *ref_llr = (float *)malloc(n*sizeof(float));
+    unsigned char *ref_dec = (unsigned char *)malloc(n);
+    float *ref_soft = (float *)malloc(n*sizeof(float));
+
+    memset(&res, 0, sizeof(res));
+    for (long b = 0; b < num_batches; b++) {
+        if (in_file) {
+            if (fread(chan, 1, BATCH*n, in_file) != (size_t)BATCH*n)
+                break;
+            for (i = 0; i < BATCH*n; i++)
+                llr[i] = chan[i];
+        } else {
+            replay_generate(&param, seed, b, ebn0, in, enc, llr);
+            for (i = 0; i < BATCH*n; i++) {
+                long q = lrintf(llr[i]);
+                chan[i] = q > 127 ? 127 : q < -127 ? -127 : q;
+            }
+        }
+
+        /* The reference runs as many iterations as the batch, which early termination ends
+         * only once all of its codewords have converged
+         */
+        ldpc_decoder_stats_reset(decoder);
+        ldpc_decode(decoder, chan, dec);
+        ldpc_decoder_status(decoder, status);
+        ldpc_decoder_stats(decoder, &stats);
+        iterations = stats.iterations;
+        if (!statistical)
+            ldpc_decode_soft(decoder, chan, soft);
+
+        mismatch = 0;
+        for (cw = 0; cw < BATCH; cw++) {
+            for (i = 0; i < n; i++)
+                ref_llr[i] = chan[cw*n + i];
+
+            if (statistical) {
+                /* The float reference gets the unquantized LLRs and stops on its own */
+                if (use_float)
+                    ldpc_ref_decode(ref, llr + cw*n, 0, ref_dec, NULL, &ref_status);
+                else
+                    ldpc_ref_decode(ref, ref_llr, (int)iterations, ref_dec, NULL, &ref_status);
+                res.dec_failed += !status[cw].valid;
+                res.ref_failed += !ref_status.valid;
+                res.dec_only += !status[cw].valid && ref_status.valid;
+                res.ref_only += status[cw].valid && !ref_status.valid;
+                res.dec_iterations += status[cw].iterations;
+                res.ref_iterations += ref_status.iterations;
+                continue;
+            }
+
+            ldpc_ref_decode(ref, ref_llr, (int)iterations, ref_dec, ref_soft, &ref_status);
+
+            int hard_diff = -1, soft_diff = -1;
+            for (i = 0; i < k && hard_diff < 0; i++)
+                if (dec[cw*k + i] != ref_dec[i])
+                    hard_diff = i;
+            for (i = 0; i < soft_len && soft_diff < 0; i++)
+                if (soft[cw*soft_len + i] != (char)ref_soft[i])
+                    soft_diff = i;
+            int status_diff = status[cw].valid != ref_status.valid || status[cw].iterations != ref_status.iterations;
+
+            res.hard_mismatch += hard_diff >= 0;
+            res.soft_mismatch += soft_diff >= 0;
+            res.status_mismatch += status_diff;
+            if (hard_diff >= 0 || soft_diff >= 0 || status_diff) {
+                if (!mismatch)
+                    fprintf(stderr, "Batch %ld, codeword %d: first hard decision difference at bit %d, first soft output difference at bit %d, "
+                            "status valid %d/%d iterations %d/%d (decoder/reference)\n",
+                            b, cw, hard_diff, soft_diff, status[cw].valid, ref_status.valid, status[cw].iterations, ref_status.iterations);
+                mismatch = 1;
+            }
+        }
+        if (mismatch && out_file)
+            fwrite(chan, 1, BATCH*n, out_file);
+
+        res.batches++;
+        res.frames += BATCH;
+    }
+
+    if (statistical) {
+        /* McNemar's test on the codewords only one of the decoders failed on */
+        long d = res.dec_only + res.ref_only;
+        double z = d ? (res.dec_only - res.ref_only) / sqrt((double)d) : 0.0;
+
+        printf("frames,dec_fer,ref_fer,dec_only,ref_only,z,dec_avg_iterations,ref_avg_iterations\n");
+        printf("%ld,%.6e,%.6e,%ld,%ld,%.2f,%.3f,%.3f\n", res.frames,
+               res.frames ? (double)res.dec_failed / res.frames : 0.0,
+               res.frames ? (double)res.ref_failed / res.frames : 0.0,
+               res.dec_only, res.ref_only, z,
+               res.frames ? (double)res.dec_iterations / res.frames : 0.0,
+               res.frames ? (double)res.ref_iterations / res.frames : 0.0);
+        mismatch = fabs(z) > REPLAY_MAX_Z;
+    } else {
+        printf("frames,hard_mismatch,soft_mismatch,status_mismatch\n");
+        printf("%ld,%ld,%ld,%ld\n", res.frames, res.hard_mismatch, res.soft_mismatch, res.status_mismatch);
+        mismatch = res.hard_mismatch || res.soft_mismatch || res.status_mismatch;
+    }
+
+    free(in);
+    free(enc);
+    free(llr);
+    free(chan);
+    free(dec);
+    free(soft);
+    free(ref_llr);
+    free(ref_dec);
+    free(ref_soft);
+    ldpc_ref_destroy(ref);
+    ldpc_destroy(decoder);
+    ldpc_param_destroy(&param);
+    if (in_file)
+        fclose(in_file);
+    if (out_file)
+        fclose(out_file);
+
+    return mismatch;
+}
@@ -0,0 +1,181 @@
+/*****************************************************************
+    Shared-memory interface to a decoder running in another process,
+    see ldpc_daemon.c.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#include "ldpc_shm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <x86intrin.h>
+
+static size_t align64(size_t x) {
+    return (x + 63) & ~(size_t)63;
+}
+
+size_t ldpc_shm_layout(ldpc_shm_header_t *hdr, int num_slots, size_t input_size, size_t output_size) {
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->magic = LDPC_SHM_MAGIC;
+    hdr->version = LDPC_SHM_VERSION;
+    hdr->num_slots = num_slots;
+    hdr->input_size = input_size;
+    hdr->output_size = output_size;
+    hdr->ring_size = align64(sizeof(ldpc_shm_ring_t) + num_slots*sizeof(uint32_t));
+    hdr->slot_offset = align64(sizeof(ldpc_shm_header_t)) + 2*hdr->ring_size;
+    hdr->slot_size = align64(sizeof(ldpc_shm_result_t)) + align64(input_size) + align64(output_size);
+    hdr->total_size = hdr->slot_offset + num_slots*hdr->slot_size;
+
+    return hdr->total_size;
+}
+
+ldpc_shm_ring_t *ldpc_shm_sq(const ldpc_shm_header_t *hdr, void *mem) {
+    return (ldpc_shm_ring_t *)((char *)mem + align64(sizeof(ldpc_shm_header_t)));
+}
+
+ldpc_shm_ring_t *ldpc_shm_cq(const ldpc_shm_header_t *hdr, void *mem) {
+    return (ldpc_shm_ring_t *)((char *)mem + align64(sizeof(ldpc_shm_header_t)) + hdr->ring_size);
+}
+
+ldpc_shm_result_t *ldpc_shm_slot_result(const ldpc_shm_header_t *hdr, void *mem, int slot) {
+    return (ldpc_shm_result_t *)((char *)mem + hdr->slot_offset + slot*hdr->slot_size);
+}
+
+char *ldpc_shm_slot_input(const ldpc_shm_header_t *hdr, void *mem, int slot) {
+    return (char *)ldpc_shm_slot_result(hdr, mem, slot) + align64(sizeof(ldpc_shm_result_t));
+}
+
+unsigned char *ldpc_shm_slot_output(const ldpc_shm_header_t *hdr, void *mem, int slot) {
+    return (unsigned char *)ldpc_shm_slot_input(hdr, mem, slot) + align64(hdr->input_size);
+}
+
+ldpc_shm_client_t *ldpc_shm_connect(const char *socket_path) {
+    ldpc_shm_client_t *c;
+    struct sockaddr_un addr;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    char buf[CMSG_SPACE(sizeof(int))];
+    char byte;
+    int fd;
+
+    c = (ldpc_shm_client_t *)calloc(1, sizeof(ldpc_shm_client_t));
+    c->sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+    if (c->sock < 0 || connect(c->sock, (struct sockaddr *)&addr, sizeof(addr))) {
+        fprintf(stderr, "Error connecting to %s\n", socket_path);
+        goto fail;
+    }
+
+    /* The daemon answers with the shared memory file descriptor */
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = buf;
+    msg.msg_controllen = sizeof(buf);
+    if (recvmsg(c->sock, &msg, 0) != 1 || !(cmsg = CMSG_FIRSTHDR(&msg)) || cmsg->cmsg_type != SCM_RIGHTS) {
+        fprintf(stderr, "No shared memory received from %s\n", socket_path);
+        goto fail;
+    }
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+
+    if (pread(fd, &c->hdr, sizeof(c->hdr), 0) != sizeof(c->hdr) || c->hdr.magic != LDPC_SHM_MAGIC ||
+        c->hdr.version != LDPC_SHM_VERSION) {
+        fprintf(stderr, "Incompatible decoder daemon at %s\n", socket_path);
+        close(fd);
+        goto fail;
+    }
+    c->mem = mmap(NULL, c->hdr.total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (c->mem == MAP_FAILED) {
+        fprintf(stderr, "Error mapping the shared memory\n");
+        goto fail;
+    }
+    c->sq = ldpc_shm_sq(&c->hdr, c->mem);
+    c->cq = ldpc_shm_cq(&c->hdr, c->mem);
+
+    return c;
+
+fail:
+    if (c->sock >= 0)
+        close(c->sock);
+    free(c);
+    return NULL;
+}
+
+void ldpc_shm_disconnect(ldpc_shm_client_t *c) {
+    munmap(c->mem, c->hdr.total_size);
+    close(c->sock);
+    free(c);
+}
+
+int ldpc_shm_num_slots(ldpc_shm_client_t *c) {
+    return (int)c->hdr.num_slots;
+}
+
+ldpc_shm_result_t *ldpc_shm_result(ldpc_shm_client_t *c, int slot) {
+    return ldpc_shm_slot_result(&c->hdr, c->mem, slot);
+}
+
+char *ldpc_shm_input(ldpc_shm_client_t *c, int slot) {
+    return ldpc_shm_slot_input(&c->hdr, c->mem, slot);
+}
+
+unsigned char *ldpc_shm_output(ldpc_shm_client_t *c, int slot) {
+    return ldpc_shm_slot_output(&c->hdr, c->mem, slot);
+}
+
+void ldpc_shm_submit(ldpc_shm_client_t *c, int slot) {
+    ldpc_shm_ring_push(c->sq, c->hdr.num_slots, slot);
+}
+
+int ldpc_shm_poll(ldpc_shm_client_t *c) {
+    return ldpc_shm_ring_pop(c->cq, c->hdr.num_slots);
+}
+
+int ldpc_shm_wait(ldpc_shm_client_t *c) {
+    const struct timespec nap = { 0, 50000 };
+    struct pollfd pfd = { c->sock, POLLIN, 0 };
+    int slot;
+
+    for (long spin = 0; (slot = ldpc_shm_poll(c)) < 0; spin++) {
+        if (spin < LDPC_SHM_SPIN) {
+            _mm_pause();
+            continue;
+        }
+        /* Idle for a while: sleep between polls, and notice if the daemon is gone */
+        if (poll(&pfd, 1, 0) > 0)
+            return -1;
+        nanosleep(&nap, NULL);
+    }
+
+    return slot;
+}
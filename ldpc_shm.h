@@ -0,0 +1,141 @@
+/*****************************************************************
+    Shared-memory interface to a decoder running in another process,
+    see ldpc_daemon.c.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#ifndef LDPC_SHM_H
+#define LDPC_SHM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ldpc.h"
+
+/* A client connects to the daemon's Unix socket and receives a shared memory
+ * file descriptor. The memory holds a header, two rings, and num_slots batch
+ * slots. A slot holds the input LLRs of one batch of 128 codewords, and the hard
+ * decisions and status written back by the decoder.
+ *
+ * The client owns the slots. It fills a free slot and pushes its index on the
+ * submission ring, and the daemon pushes the index on the completion ring when the
+ * batch is decoded. Each ring has one producer and one consumer, and holds
+ * num_slots entries, so it can never overflow. After the setup, no system calls
+ * are made while there is work in the rings.
+ */
+
+#define LDPC_SHM_MAGIC 0x4350444c /* "LDPC" */
+#define LDPC_SHM_VERSION 1
+
+/* Single-producer single-consumer ring of slot indices */
+typedef struct {
+    uint32_t head __attribute__ ((aligned (64))); /* Next entry to consume, written by the consumer */
+    uint32_t tail __attribute__ ((aligned (64))); /* Next entry to produce, written by the producer */
+    uint32_t entry[] __attribute__ ((aligned (64)));
+} ldpc_shm_ring_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_slots; /* A power of two */
+    uint32_t input_size; /* Bytes of input LLRs per slot, see ldpc_decoder_input_size */
+    uint32_t output_size; /* Bytes of hard decisions per slot, see ldpc_decoder_output_size */
+    uint64_t ring_size; /* Bytes of each ring, entries included */
+    uint64_t slot_offset; /* Offset of the first slot from the start of the memory */
+    uint64_t slot_size; /* Bytes of each slot */
+    uint64_t total_size;
+} ldpc_shm_header_t;
+
+/* Result of a batch, followed in the slot by the input and output arrays */
+typedef struct {
+    int32_t num_valid; /* Return value of ldpc_decode */
+    ldpc_status_t status[128];
+} ldpc_shm_result_t;
+
+/* Client side of a connection */
+typedef struct {
+    int sock;
+    void *mem;
+    ldpc_shm_header_t hdr; /* Copy of the header, as read before mapping the memory */
+    ldpc_shm_ring_t *sq; /* Submission ring, produced by the client */
+    ldpc_shm_ring_t *cq; /* Completion ring, produced by the daemon */
+} ldpc_shm_client_t;
+
+/* Connect to the daemon listening on socket_path. Returns NULL on failure. */
+ldpc_shm_client_t *ldpc_shm_connect(const char *socket_path);
+
+/* Close the connection. The daemon finishes the batches already submitted and waits for the next client. */
+void ldpc_shm_disconnect(ldpc_shm_client_t *c);
+
+/* Number of slots */
+int ldpc_shm_num_slots(ldpc_shm_client_t *c);
+
+/* The arrays of a slot, in the layout of ldpc_decode */
+char *ldpc_shm_input(ldpc_shm_client_t *c, int slot);
+unsigned char *ldpc_shm_output(ldpc_shm_client_t *c, int slot);
+ldpc_shm_result_t *ldpc_shm_result(ldpc_shm_client_t *c, int slot);
+
+/* Submit the batch in a slot for decoding */
+void ldpc_shm_submit(ldpc_shm_client_t *c, int slot);
+
+/* Get the slot of a decoded batch, or -1 if none is done yet */
+int ldpc_shm_poll(ldpc_shm_client_t *c);
+
+/* Wait for a decoded batch and return its slot. Returns -1 if the daemon has gone away. */
+int ldpc_shm_wait(ldpc_shm_client_t *c);
+
+/* Helpers shared with the daemon */
+
+/* Busy-wait iterations on an empty ring before sleeping between polls */
+#define LDPC_SHM_SPIN 100000
+
+/* Bytes needed for the shared memory of a decoder, and its layout in hdr */
+size_t ldpc_shm_layout(ldpc_shm_header_t *hdr, int num_slots, size_t input_size, size_t output_size);
+
+/* Rings and slots of the shared memory at mem, in the layout of hdr. hdr should be a
+ * private copy, not the header in the memory, which the other side can overwrite.
+ */
+ldpc_shm_ring_t *ldpc_shm_sq(const ldpc_shm_header_t *hdr, void *mem);
+ldpc_shm_ring_t *ldpc_shm_cq(const ldpc_shm_header_t *hdr, void *mem);
+ldpc_shm_result_t *ldpc_shm_slot_result(const ldpc_shm_header_t *hdr, void *mem, int slot);
+char *ldpc_shm_slot_input(const ldpc_shm_header_t *hdr, void *mem, int slot);
+unsigned char *ldpc_shm_slot_output(const ldpc_shm_header_t *hdr, void *mem, int slot);
+
+/* Push and pop slot indices. Push never fails as the rings hold every slot, and pop returns -1 if the ring is empty. */
+static inline void ldpc_shm_ring_push(ldpc_shm_ring_t *r, uint32_t num_slots, uint32_t slot) {
+    uint32_t tail = r->tail;
+
+    r->entry[tail & (num_slots - 1)] = slot;
+    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static inline int ldpc_shm_ring_pop(ldpc_shm_ring_t *r, uint32_t num_slots) {
+    uint32_t head = r->head;
+    int slot;
+
+    if (head == __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE))
+        return -1;
+    slot = (int)r->entry[head & (num_slots - 1)];
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+
+    return slot;
+}
+
+#endif //LDPC_SHM_H
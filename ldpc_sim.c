@@ -0,0 +1,345 @@
+/*****************************************************************
+    Monte-Carlo BER/FER simulation of an LDPC code over an AWGN channel
+    with BPSK modulation.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#include "ldpc.h"
+#include "alist.h"
+#include "channel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#define BATCH 128
+
+typedef struct {
+    /* Configuration */
+    ldpc_param_t *param;
+    int num_shortened; /* Leading data bits that are shortened */
+    int num_sent; /* Transmitted bits of each codeword */
+    const char *sent; /* Flags the bits of H that are neither shortened nor punctured */
+    int packed_bits; /* Width of the packed LLRs given to the decoder, 0 for float LLRs */
+    float ebn0;
+    int point;
+    uint64_t seed;
+    long min_frame_errors;
+    long max_frames;
+
+    /* Shared progress, protected by lock */
+    pthread_mutex_t lock;
+    long next_batch;
+    long frames;
+    long bit_errors;
+    long frame_errors;
+    long cut_off_frames;
+    long iterations;
+    double decode_time;
+} sim_point_t;
+
+typedef struct {
+    sim_point_t *pt;
+    ldpc_t *decoder;
+} sim_job_t;
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void *sim_worker(void *arg) {
+    sim_job_t *job = (sim_job_t *)arg;
+    sim_point_t *pt = job->pt;
+    ldpc_code_t *H = pt->param->code;
+    ldpc_status_t status[BATCH];
+    channel_rng_t rng;
+    long batch, bit_errors, frame_errors, cut_off_frames, iterations;
+    double t;
+    int cw, i, e;
+
+    /* Data bits and transmitted bits of each codeword */
+    int k = H->K - pt->num_shortened;
+    int n = pt->num_sent;
+    char *input = (char *)malloc(BATCH*H->K*sizeof(char));
+    char *enc = (char *)malloc(BATCH*H->N*sizeof(char));
+    float *llr = (float *)malloc(BATCH*H->N*sizeof(float));
+    unsigned char *dec = (unsigned char *)malloc(BATCH*k*sizeof(unsigned char));
+    size_t stride = ((size_t)n*pt->packed_bits + 7)/8; /* Bytes per packed codeword */
+    char *quant = (char *)malloc(n*sizeof(char));
+    unsigned char *packed = (unsigned char *)malloc(BATCH*stride);
+    float sigma = channel_sigma(pt->ebn0, (float)k / n);
+
+    for (;;) {
+        pthread_mutex_lock(&pt->lock);
+        if (pt->frame_errors >= pt->min_frame_errors || pt->next_batch*BATCH >= pt->max_frames) {
+            pthread_mutex_unlock(&pt->lock);
+            break;
+        }
+        batch = pt->next_batch++;
+        pthread_mutex_unlock(&pt->lock);
+
+        /* Each batch has its own random stream, so results do not depend on the number of jobs */
+        channel_rng_init(&rng, pt->seed ^ ((uint64_t)pt->point << 40), (uint32_t)batch);
+        channel_random_bits(&rng, input, BATCH*H->K);
+        for (cw = 0; cw < BATCH; cw++) {
+            memset(input + cw*H->K, 0, pt->num_shortened);
+            ldpc_encode(pt->param, H->K, input + cw*H->K, enc + cw*H->N);
+            /* Only the transmitted bits are sent */
+            for (i = 0, e = 0; i < H->N; i++)
+                if (pt->sent[i])
+                    enc[cw*n + e++] = enc[cw*H->N + i];
+        }
+        channel_awgn_bpsk(&rng, enc, BATCH*n, sigma, llr);
+
+        if (pt->packed_bits) {
+            /* Quantized and packed like a demodulator would, before the decoder gets them */
+            for (cw = 0; cw < BATCH; cw++) {
+                for (i = 0; i < n; i++) {
+                    long q = lrintf(llr[cw*n + i]*pt->param->llr_scale);
+                    quant[i] = q > 127 ? 127 : q < -127 ? -127 : q;
+                }
+                ldpc_llr_pack(quant, n, pt->packed_bits, packed + cw*stride);
+            }
+            t = now();
+            ldpc_decode_packed(job->decoder, packed, pt->packed_bits, dec);
+        } else {
+            t = now();
+            ldpc_decode_float(job->decoder, llr, NULL, dec);
+        }
+        t = now() - t;
+        ldpc_decoder_status(job->decoder, status);
+
+        bit_errors = frame_errors = cut_off_frames = iterations = 0;
+        for (cw = 0; cw < BATCH; cw++) {
+            e = 0;
+            for (i = 0; i < k; i++)
+                e += input[cw*H->K + pt->num_shortened + i] != dec[cw*k + i];
+            bit_errors += e;
+            frame_errors += e > 0;
+            cut_off_frames += status[cw].cut_off;
+            iterations += status[cw].iterations;
+        }
+
+        pthread_mutex_lock(&pt->lock);
+        pt->frames += BATCH;
+        pt->bit_errors += bit_errors;
+        pt->frame_errors += frame_errors;
+        pt->cut_off_frames += cut_off_frames;
+        pt->iterations += iterations;
+        pt->decode_time += t;
+        pthread_mutex_unlock(&pt->lock);
+    }
+
+    free(input);
+    free(enc);
+    free(llr);
+    free(dec);
+    free(quant);
+    free(packed);
+
+    return NULL;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "Usage: %s -m matrix.alist [options]\n"
+        "  -s start     First Eb/N0 point in dB (default 1.0)\n"
+        "  -e end       Last Eb/N0 point in dB (default 2.0)\n"
+        "  -d step      Eb/N0 step in dB (default 0.1)\n"
+        "  -f errors    Frame errors to collect per point (default 100)\n"
+        "  -n frames    Maximum number of frames per point (default 1000000)\n"
+        "  -j jobs      Number of decoders running in parallel (default: number of cores)\n"
+        "  -t threads   Worker threads per decoder (default 1)\n"
+        "  -i iter      Maximum number of iterations (default 30)\n"
+        "  -a alg       Check node rule: ms, oms or nms (default ms)\n"
+        "  -p bits      Message precision: 8 or 16 (default 8)\n"
+        "  -b iter      Bit-flipping iterations before min-sum (default 0, disabled)\n"
+        "  -z bits      Shorten the code by this many leading data bits (default 0)\n"
+        "  -x bits      Puncture this many parity bits, evenly spaced (default 0)\n"
+        "  -T us        Deadline of each batch in microseconds (default 0, none)\n"
+        "  -I iter      Iteration budget per batch, shared by the batches of a job (default 0, none)\n"
+        "  -q scale     Fixed LLR quantization scale (default 4)\n"
+        "  -A target    Adaptive LLR scaling to the given mean magnitude\n"
+        "  -G           Early termination on the parity of the check node input signs\n"
+        "  -P bits      Quantize LLRs with the fixed scale and pack them to 4 to 8 bits (default 0, float input)\n"
+        "  -S seed      Random seed (default 1)\n"
+        "  -o file      Write CSV to file instead of stdout\n", prog);
+}
+
+int main(int argc, char **argv) {
+    ldpc_code_t *H;
+    ldpc_param_t param;
+    char *matrix = NULL;
+    FILE *out = stdout;
+    float start = 1.0f, end = 2.0f, step = 0.1f;
+    long min_frame_errors = 100, max_frames = 1000000;
+    int jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t seed = 1;
+    sim_point_t pt;
+    sim_job_t *job;
+    pthread_t *threads;
+    double t;
+    int c, j, point;
+    int num_shortened = 0, num_punctured = 0, packed_bits = 0;
+    char *sent;
+
+    ldpc_param_init(&param);
+    param.num_threads = 1;
+
+    while ((c = getopt(argc, argv, "m:s:e:d:f:n:j:t:i:a:p:b:z:x:T:I:q:A:P:GS:o:h")) != -1) {
+        switch (c) {
+        case 'm': matrix = optarg; break;
+        case 's': start = atof(optarg); break;
+        case 'e': end = atof(optarg); break;
+        case 'd': step = atof(optarg); break;
+        case 'f': min_frame_errors = atol(optarg); break;
+        case 'n': max_frames = atol(optarg); break;
+        case 'j': jobs = atoi(optarg); break;
+        case 't': param.num_threads = atoi(optarg); break;
+        case 'i': param.max_iter = atoi(optarg); break;
+        case 'a':
+            if (!strcmp(optarg, "oms"))
+                param.algorithm = LDPC_OFFSET_MIN_SUM;
+            else if (!strcmp(optarg, "nms"))
+                param.algorithm = LDPC_NORMALIZED_MIN_SUM;
+            else
+                param.algorithm = LDPC_MIN_SUM;
+            break;
+        case 'p': param.precision = atoi(optarg) == 16 ? LDPC_PRECISION_16 : LDPC_PRECISION_8; break;
+        case 'b': param.bf_max_iter = atoi(optarg); break;
+        case 'z': num_shortened = atoi(optarg); break;
+        case 'x': num_punctured = atoi(optarg); break;
+        case 'T': param.deadline_us = atoi(optarg); break;
+        case 'I': param.iter_budget = atoi(optarg); break;
+        case 'q': param.llr_scaling = LDPC_LLR_SCALE_FIXED; param.llr_scale = atof(optarg); break;
+        case 'A': param.llr_scaling = LDPC_LLR_SCALE_ADAPTIVE; param.llr_target = atof(optarg); break;
+        case 'P': packed_bits = atoi(optarg); break;
+        case 'G': param.sign_parity = 1; break;
+        case 'S': seed = strtoull(optarg, NULL, 0); break;
+        case 'o':
+            if (!(out = fopen(optarg, "w"))) {
+                fprintf(stderr, "Error opening output file %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!matrix || step <= 0.0f || jobs < 1 || (packed_bits && (packed_bits < LDPC_PACKED_MIN_BITS || packed_bits > 8))) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    H = ldpc_alist_load(matrix);
+    if (!H)
+        return 1;
+    param.code = H;
+
+    if (num_shortened < 0 || num_shortened >= H->K || num_punctured < 0 || num_punctured > H->M) {
+        fprintf(stderr, "Invalid number of shortened or punctured bits\n");
+        return 1;
+    }
+    param.shortened = (int *)malloc(num_shortened*sizeof(int));
+    param.num_shortened = num_shortened;
+    for (j = 0; j < num_shortened; j++)
+        param.shortened[j] = j;
+    param.punctured = (int *)malloc(num_punctured*sizeof(int));
+    param.num_punctured = num_punctured;
+    for (j = 0; j < num_punctured; j++)
+        param.punctured[j] = H->K + (int)((long)j*H->M/num_punctured);
+
+    sent = (char *)malloc(H->N*sizeof(char));
+    memset(sent, 1, H->N);
+    for (j = 0; j < num_shortened; j++)
+        sent[param.shortened[j]] = 0;
+    for (j = 0; j < num_punctured; j++)
+        sent[param.punctured[j]] = 0;
+
+    /* Every job has a decoder of its own */
+    job = (sim_job_t *)calloc(jobs, sizeof(sim_job_t));
+    threads = (pthread_t *)malloc(jobs*sizeof(pthread_t));
+    for (j = 0; j < jobs; j++) {
+        job[j].pt = &pt;
+        job[j].decoder = ldpc_init(&param);
+        if (!job[j].decoder)
+            return 1;
+    }
+
+    fprintf(out, "ebn0_db,frames,bit_errors,frame_errors,ber,fer,avg_iterations,sim_mbps,decoder_mbps,cut_off_frames\n");
+
+    for (point = 0; start + point*step <= end + step/2; point++) {
+        memset(&pt, 0, sizeof(pt));
+        pt.param = &param;
+        pt.num_shortened = num_shortened;
+        pt.num_sent = H->N - num_shortened - num_punctured;
+        pt.sent = sent;
+        pt.packed_bits = packed_bits;
+        pt.ebn0 = start + point*step;
+        pt.point = point;
+        pt.seed = seed;
+        pt.min_frame_errors = min_frame_errors;
+        pt.max_frames = max_frames;
+        pthread_mutex_init(&pt.lock, NULL);
+
+        t = now();
+        for (j = 0; j < jobs; j++)
+            pthread_create(&threads[j], NULL, sim_worker, &job[j]);
+        for (j = 0; j < jobs; j++)
+            pthread_join(threads[j], NULL);
+        t = now() - t;
+
+        /* decoder_mbps is the decoding rate of all jobs together, excluding encoding and channel */
+        fprintf(out, "%.3f,%ld,%ld,%ld,%.6e,%.6e,%.3f,%.3f,%.3f,%ld\n",
+                pt.ebn0, pt.frames, pt.bit_errors, pt.frame_errors,
+                pt.frames ? (double)pt.bit_errors / ((double)pt.frames*(H->K - num_shortened)) : 0.0,
+                pt.frames ? (double)pt.frame_errors / pt.frames : 0.0,
+                pt.frames ? (double)pt.iterations / pt.frames : 0.0,
+                (double)pt.frames*(H->K - num_shortened) / t / 1e6,
+                pt.decode_time > 0 ? (double)pt.frames*(H->K - num_shortened)*jobs / pt.decode_time / 1e6 : 0.0,
+                pt.cut_off_frames);
+        fflush(out);
+        pthread_mutex_destroy(&pt.lock);
+
+        if (pt.frame_errors == 0)
+            break; /* Error-free point, higher SNRs are not informative */
+    }
+
+    for (j = 0; j < jobs; j++)
+        ldpc_destroy(job[j].decoder);
+    free(job);
+    free(threads);
+    free(param.shortened);
+    free(param.punctured);
+    free(sent);
+    ldpc_param_destroy(&param);
+    if (out != stdout)
+        fclose(out);
+
+    return 0;
+}
@@ -21,6 +21,38 @@
 ********************************************************************/
 
 #include "ldpc_sse.h"
+#include "reorder.h"
+#include "pool.h"
+#include "cache.h"
+
+/* Worker threads, barriers and scratch memory of a decoder. A decoder from ldpc_init
+ * owns its own, and the codes of an ldpc_engine_t share the engine's.
+ */
+typedef struct {
+    unsigned short num_threads;
+    ldpc_pool_t *pool; /* num_threads bit node workers followed by num_threads check node workers,
+                          or NULL to decode on the calling thread */
+    pthread_barrier_t barr_0;
+    pthread_barrier_t barr_1;
+    pthread_barrier_t barr_bv;
+
+    /* Scratch memory of the batch being decoded, sized for the largest code */
+    size_t msg_bytes; /* Edge messages */
+    size_t llr_bytes; /* Interleaved channel LLRs */
+    size_t bit_bytes; /* Interleaved hard decisions, and soft output */
+    ldpc_msg_t *edge_msg;
+    ldpc_llr_t *llr_interl;
+    ldpc_bit_t *bitval_interl;
+    ldpc_llr_t *soft_interl;
+    size_t row_bytes; /* Unpacked input of 16 codewords */
+    char *rows;
+} sse_ldpc_shared_t;
+
+struct ldpc_engine_t {
+    sse_ldpc_shared_t shared;
+    ldpc_t **codes;
+    int num_codes;
+};
 
 struct ldpc_t {
     int M;
@@ -34,23 +66,100 @@ struct ldpc_t {
     int *row_idx;
     int *col_idx;
 
+    /* Gather schedule of the bit node update: the edges of each bit node in column order,
+     * bit node i from bn_edge_start[i]. The bit nodes of a thread are contiguous, so each
+     * thread reads one slice of it from start to end.
+     */
+    int *bn_edges;
+    int *bn_edge_start;
+
     int *llr_map;
 
     int num_edges;
 
+    int in_len; /* Number of input values per codeword, the bits of H neither shortened nor punctured */
+
+    /* Node renumbering (see ldpc_reorder), shortening and puncturing.
+     * NULL if the decoder positions are the bits of H and all of them are transmitted.
+     */
+    int *bit_map; /* Input value of each position of the decoder, -1 for punctured bits */
+    int *bit_pos; /* Position in the decoder of each output value, the bits of H not shortened */
+
+    /* Cache file mapping holding the tables above, or NULL if they were built, see param->cache_dir */
+    void *cache_map;
+    size_t cache_map_size;
+
     struct bn_update_args *bn_args;
     struct bn_update_bitval_args *bn_bv_args;
     struct cn_update_args *cn_args;
     struct check_satisfied_args *cs_args;
 
-    char *unsatisfied_eqs;
+    ldpc_bit_t *unsat; /* Unsatisfied check masks, LDPC_CODEWORD_BLOCKS per thread */
 
     unsigned short max_iter;
     unsigned short num_threads;
-
-    pthread_barrier_t *barr_0;
-    pthread_barrier_t *barr_1;
-
+    unsigned char early_termination;
+    unsigned char sign_parity;
+
+    /* Status of the last decoded batch */
+    unsigned short conv_iter[LDPC_CODEWORD_BLOCKS*16];
+    unsigned short iterations;
+    ldpc_bit_t keep[LDPC_CODEWORD_BLOCKS]; /* Codewords whose checked hard decisions are kept, see sse_ldpc_keep_checked */
+    ldpc_status_t status[LDPC_CODEWORD_BLOCKS*16];
+
+    ldpc_soft_output_t soft_output;
+    int soft_len; /* Number of soft output values per codeword */
+
+    ldpc_llr_scaling_t llr_scaling;
+    float llr_scale;
+    float llr_target;
+
+    ldpc_precision_t precision;
+    size_t msg_size; /* Size of the messages of one edge (and of the interleaved LLRs of one bit) */
+
+    /* Hard-decision bit-flipping stage, see sse_ldpc_bit_flip */
+    unsigned short bf_max_iter;
+    unsigned char bf_threshold;
+    int bf_bits; /* Width of the bit-sliced unsatisfied check counters */
+    int *edge_row; /* Row of each edge */
+    __m128i *bf_hard; /* Hard decisions of each bit, one lane bit per codeword */
+    __m128i *bf_weak; /* Bits with unreliable channel LLRs, LDPC_BF_LEVELS masks per bit */
+    __m128i *bf_synd; /* Syndrome of each check */
+    ldpc_bit_t *bf_saved; /* Decisions of the last min-sum block, for its solved codewords, see sse_ldpc_bf_compact */
+    unsigned char active[LDPC_CODEWORD_BLOCKS]; /* Codeword blocks left to min-sum */
+    int ms_blocks; /* Number of blocks, from the first, decoded with min-sum in the last batch */
+    int ms_lanes; /* Number of codewords, from the first, decoded with min-sum in the last batch */
+    unsigned char lane_pos[LDPC_CODEWORD_BLOCKS*16]; /* Position of each codeword in the decoded batch */
+
+    /* Deadline and iteration budget, see ldpc_param_t */
+    unsigned int deadline_us;
+    unsigned int iter_budget;
+    unsigned int iter_budget_max;
+    unsigned int iter_credit; /* Iterations left to the next batch */
+    struct timespec deadline; /* Deadline of the batch being decoded */
+    struct timespec next_deadline; /* Set by ldpc_decoder_set_deadline */
+    unsigned char has_next_deadline;
+    unsigned char stop; /* The iterations were ended at the deadline */
+    unsigned char cut_off; /* The last batch was stopped before max_iter */
+
+    /* Runs of equal degree among the nodes of each thread, at the offset of its first node */
+    ldpc_degree_run_t *cn_runs;
+    ldpc_degree_run_t *bn_runs;
+    /* Node update time by degree for each thread, summed into ldpc_stats_t */
+    unsigned long long (*cn_degree_cycles)[LDPC_STATS_MAX_DEGREE];
+    unsigned long long (*bn_degree_cycles)[LDPC_STATS_MAX_DEGREE];
+
+    /* Kernels for the selected algorithm and precision */
+    void *(*bn_update)(void *);
+    void *(*bn_update_bitval)(void *);
+    void *(*cn_update)(void *);
+    void (*bn_pass)(struct bn_update_args *);
+    void (*cn_pass)(struct cn_update_args *);
+
+    sse_ldpc_shared_t *shared;
+    unsigned char own_shared; /* Not part of an engine */
+
+    ldpc_stats_t stats;
 };
 
 
@@ -60,68 +169,143 @@ void ldpc_init_messages_sse(ldpc_t *h)
     __m128i zero = _mm_setzero_si128();
     ldpc_llr_t *init_p = (ldpc_llr_t *)h->edge_msg;
 
-    for (ldpc_llr_t *p = init_p; p < init_p+(h->num_edges*LDPC_CODEWORD_BLOCKS); p++) {
+    for (ldpc_llr_t *p = init_p; p < init_p+(h->num_edges*h->msg_size/sizeof(ldpc_llr_t)); p++) {
         _mm_store_si128((__m128i *)p, zero);
     }
 
 }
 
 
-/* Bit node update without hard decision */
-void *sse_ldpc_ms_bn_update(void *threadarg) {
+/* Bit node update of the columns first..first+num-1, all of degree deg.
+ * deg is a compile-time constant in the unrolled instances: the edges of a column
+ * are read once from the schedule for all codeword blocks, and its messages stay in
+ * registers between the sum and the extrinsic update instead of being loaded twice.
+ */
+static inline __attribute__((always_inline)) void sse_ldpc_bn_cols(struct bn_update_args *arg, int first, int num, const int deg) {
+    __m128i msg[LDPC_MAX_UNROLL_DEGREE];
+    const int *edge;
+    __m128i m;
+    const __m128i one = _mm_set1_epi8(1);
+    int temp;
+
+    for (int i = first; i < first + num; i++) {
+        edge = &arg->edges[arg->edge_start[i]];
+        if (arg->prefetch)
+            sse_ldpc_prefetch_bn(arg, i + arg->prefetch, sizeof(ldpc_msg_t));
+
+        for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS; cw_block++) {
+            if (arg->active && !arg->active[cw_block])
+                continue;
+
+            temp = i*LDPC_CODEWORD_BLOCKS + cw_block;
+            m = _mm_load_si128((__m128i *)&arg->llr[temp].v);
+
+#pragma GCC unroll 32
+            for (int k = 0; k < deg; k++) {
+                msg[k] = _mm_load_si128((__m128i *)&arg->emsg[edge[k]].message[cw_block].v);
+                m = _mm_adds_epi8(m, msg[k]);
+            }
+
+#pragma GCC unroll 32
+            for (int k = 0; k < deg; k++) {
+                //Hack: We do not want -128, as that ruins correction performance
+                _mm_store_si128((__m128i *)&arg->emsg[edge[k]].message[cw_block].v,
+                                _mm_adds_epi8(_mm_subs_epi8(m, msg[k]), one));
+            }
+
+            // Hard decision for the parity check during the check node update
+            if (arg->bitval && !arg->sign_parity)
+                _mm_store_si128((__m128i *)&arg->bitval[temp].v, _mm_and_si128(_mm_srli_epi16(m, 7), one));
+        }
+    }
+}
 
+/* Bit node update of columns of any degree, from the edge schedule */
+static void sse_ldpc_bn_cols_generic(struct bn_update_args *arg, int first, int num) {
     __m128i msg;
     __m128i m;
-    __m128i xmmtmp;
-    const __m128i mesfloor = _mm_set1_epi8(-127);
-    int col_start;
-
-    int index;
+    const __m128i xmmtmp = _mm_set1_epi8(1);
+    int start, end;
     int temp;
-    struct bn_update_args *arg;
-    arg = (struct bn_update_args *) threadarg;
-    unsigned short iter = 0;
 
-    xmmtmp = _mm_set1_epi8(1);
+    for (int i = first; i < first + num; i++) {
+        start = arg->edge_start[i];
+        end = arg->edge_start[i+1];
+        if (arg->prefetch)
+            sse_ldpc_prefetch_bn(arg, i + arg->prefetch, sizeof(ldpc_msg_t));
 
-    while (iter++ < arg->max_iter)
-    {
-        for (int i=arg->first_n; i < arg->first_n + arg->num_n; i++) {
-            for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS;cw_block++) {
+        for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS;cw_block++) {
+            if (arg->active && !arg->active[cw_block])
+                continue;
 
-                col_start = arg->col_idx[i];
-                index = col_start;
-                temp = (i*LDPC_CODEWORD_BLOCKS + cw_block);
+            temp = (i*LDPC_CODEWORD_BLOCKS + cw_block);
 
-                m = _mm_load_si128((__m128i *)&arg->llr[temp].v);
+            m = _mm_load_si128((__m128i *)&arg->llr[temp].v);
 
-                do {
-                    msg = _mm_load_si128((__m128i *)&arg->emsg[index].message[cw_block].v);
+            for (int j = start; j < end; j++) {
+                msg = _mm_load_si128((__m128i *)&arg->emsg[arg->edges[j]].message[cw_block].v);
 
-                    m = _mm_adds_epi8(m, msg);
+                m = _mm_adds_epi8(m, msg);
+            }
 
-                    index = arg->hc[index].i_next;
-                } while (index != col_start);
+            for (int j = start; j < end; j++) {
+                msg = _mm_load_si128((__m128i *)&arg->emsg[arg->edges[j]].message[cw_block].v);
 
-                do {
-                    msg = _mm_load_si128((__m128i *)&arg->emsg[index].message[cw_block].v);
+                msg = _mm_subs_epi8(m, msg);
+                //Hack: We do not want -128, as that ruins correction performance
+                msg = _mm_adds_epi8(msg, xmmtmp);
 
-                    msg = _mm_subs_epi8(m, msg);
-                    //Hack: We do not want -128, as that ruins correction performance
-                    msg = _mm_adds_epi8(msg, xmmtmp);
-                    //msg = _mm_min_epu8(msg,mesfloor);
+                _mm_store_si128((__m128i *)&arg->emsg[arg->edges[j]].message[cw_block].v, msg);
+            }
 
-                    _mm_store_si128((__m128i *)&arg->emsg[index].message[cw_block].v, msg);
-                    index = arg->hc[index].i_next;
-                } while (index != col_start);
+            // Hard decision for the parity check during the check node update
+            if (arg->bitval && !arg->sign_parity)
+                _mm_store_si128((__m128i *)&arg->bitval[temp].v, _mm_and_si128(_mm_srli_epi16(m, 7), xmmtmp));
+        }
+    }
+}
 
-            }
+/* One bit node update of the columns of a thread */
+void sse_ldpc_bn_pass(struct bn_update_args *arg) {
+    unsigned long long tsc;
+
+    for (int r = 0; r < arg->num_runs; r++) {
+        ldpc_degree_run_t *run = &arg->runs[r];
+
+        tsc = __rdtsc();
+        switch (run->deg) {
+#define SSE_LDPC_BN_CASE(d) case d: sse_ldpc_bn_cols(arg, run->first_n, run->num_n, d); break;
+        LDPC_UNROLLED_DEGREES(SSE_LDPC_BN_CASE)
+#undef SSE_LDPC_BN_CASE
+        default:
+            sse_ldpc_bn_cols_generic(arg, run->first_n, run->num_n);
+            break;
         }
-        pthread_barrier_wait(arg->barr_0);
-        pthread_barrier_wait(arg->barr_1);
+        arg->degree_cycles[IMIN(run->deg, LDPC_STATS_MAX_DEGREE - 1)] += __rdtsc() - tsc;
+    }
+}
+
+/* Bit node update without hard decision */
+void *sse_ldpc_ms_bn_update(void *threadarg) {
+    struct bn_update_args *arg;
+    arg = (struct bn_update_args *) threadarg;
+    unsigned short iter = 0;
+    unsigned long long wait = 0;
+
+    while (iter++ < arg->max_iter)
+    {
+        sse_ldpc_bn_pass(arg);
+        sse_ldpc_barrier_wait(arg->barr_0, &wait);
+        sse_ldpc_barrier_wait(arg->barr_1, &wait);
+
+        if (*arg->stop)
+            break;
+        if (arg->bitval && sse_ldpc_all_satisfied(arg->unsat_all, arg->num_threads))
+            break;
     }
 
-    pthread_exit(NULL);
+    *arg->wait_cycles += wait;
+    return NULL;
 }
 
 /* Bit node update with hard decision */
@@ -137,9 +321,12 @@ void *sse_ldpc_ms_bn_update_bitval(void *threadarg) {
     int temp;
     struct bn_update_bitval_args *arg;
     arg = (struct bn_update_bitval_args *) threadarg;
+    unsigned long long wait = 0;
 
     for (int i=arg->first_n; i < arg->first_n + arg->num_n; i++) {
         for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS;cw_block++) {
+            if (arg->active && !arg->active[cw_block])
+                continue;
 
             col_start = arg->col_idx[i];
             index = col_start;
@@ -171,102 +358,290 @@ void *sse_ldpc_ms_bn_update_bitval(void *threadarg) {
             // bitval should be sign bit of m
             msg = _mm_srli_epi16(m, 7);
             msg = _mm_and_si128(msg, xmmtmp);
+            if (arg->keep)
+                msg = VEC_BLEND(msg, _mm_load_si128((__m128i *)&arg->bitval[temp].v), _mm_load_si128((__m128i *)&arg->keep[cw_block].v));
             _mm_store_si128((__m128i *)&arg->bitval[temp].v, msg);
 
+            if (arg->soft) {
+                if (arg->extrinsic)
+                    m = _mm_subs_epi8(m, _mm_load_si128((__m128i *)&arg->llr[temp].v));
+                _mm_store_si128((__m128i *)&arg->soft[temp].v, VEC_MAX_EPI8(m, mesfloor));
+            }
+
         }
     }
 
-    pthread_exit(NULL);
+    /* Check the parity of the final hard decisions once all threads have made them */
+    sse_ldpc_barrier_wait(arg->barr, &wait);
+    sse_ldpc_check_unsatisfied(arg->cs);
+
+    *arg->wait_cycles += wait;
+    return NULL;
 }
 
-void *sse_ldpc_ms_cn_update(void *threadarg) {
-    __m128i minLLR, nMinLLR, absol, minMsg,tmp1, tmp2, mask1, mask2, mask3, msg, sign, zero;
+/* Scale unsigned 8-bit magnitudes (0..127) by alpha/128, rounding to nearest */
+static inline __m128i sse_ldpc_scale_epu8(__m128i x, __m128i alpha) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(64);
+    __m128i lo, hi;
+
+    lo = _mm_unpacklo_epi8(x, zero);
+    hi = _mm_unpackhi_epi8(x, zero);
+    lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, alpha), round), 7);
+    hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, alpha), round), 7);
+
+    return _mm_packus_epi16(lo, hi);
+}
+
+/* Apply the min-sum correction of the algorithm to the two smallest magnitudes */
+static inline __attribute__((always_inline)) void sse_ldpc_cn_correct(__m128i *minLLR, __m128i *nMinLLR, __m128i offset, __m128i alpha, const ldpc_algorithm_t algorithm) {
+    if (algorithm == LDPC_OFFSET_MIN_SUM) {
+        *minLLR = _mm_subs_epu8(*minLLR, offset);
+        *nMinLLR = _mm_subs_epu8(*nMinLLR, offset);
+    } else if (algorithm == LDPC_NORMALIZED_MIN_SUM) {
+        *minLLR = sse_ldpc_scale_epu8(*minLLR, alpha);
+        *nMinLLR = sse_ldpc_scale_epu8(*nMinLLR, alpha);
+    }
+}
+
+/* Check node update of the rows first..first+num-1, all of degree deg.
+ * The edges of a row are numbered consecutively (see ldpc_init_sse), and with deg
+ * a compile-time constant the messages of a row stay in registers between the two
+ * passes. The edge sending the minimum is recognized by its magnitude: if several
+ * edges share it, the second minimum equals the minimum and the result is the same.
+ */
+static inline __attribute__((always_inline)) void sse_ldpc_cn_rows(struct cn_update_args *arg, int first, int num, const int deg, const ldpc_algorithm_t algorithm) {
+    __m128i msg[LDPC_MAX_UNROLL_DEGREE];
+    __m128i minLLR, nMinLLR, cMinLLR, cNMinLLR, absol, sign, parity, mask;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i offset = _mm_set1_epi8(arg->offset);
+    const __m128i alpha = _mm_set1_epi16(arg->alpha);
+    const int gather = arg->bitval && !arg->sign_parity;
+
+    for (int i = first; i < first + num; i++) {
+        ldpc_msg_t *emsg = &arg->emsg[arg->row_idx[i]];
+        int *llr_map = &arg->llr_map[arg->row_idx[i]];
+
+        for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS; cw_block++) {
+            if (arg->active && !arg->active[cw_block])
+                continue;
+            minLLR = _mm_set1_epi8(127);
+            nMinLLR = _mm_set1_epi8(127);
+            sign = zero;
+            parity = zero;
+
+#pragma GCC unroll 32
+            for (int k = 0; k < deg; k++) {
+                msg[k] = _mm_load_si128((__m128i *)&emsg[k].message[cw_block].v);
+
+                //Parity of the hard decisions of the previous bit node update
+                if (gather)
+                    parity = _mm_xor_si128(parity, _mm_load_si128((__m128i *)&arg->bitval[llr_map[k]*LDPC_CODEWORD_BLOCKS + cw_block].v));
+
+                sign = _mm_xor_si128(sign, msg[k]);
+                absol = _mm_abs_epi8(msg[k]);
+                nMinLLR = _mm_min_epu8(nMinLLR, _mm_max_epu8(minLLR, absol));
+                minLLR = _mm_min_epu8(minLLR, absol);
+            }
+
+            cMinLLR = minLLR;
+            cNMinLLR = nMinLLR;
+            sse_ldpc_cn_correct(&cMinLLR, &cNMinLLR, offset, alpha, algorithm);
+
+            sign = _mm_cmplt_epi8(sign, zero); //0xFF = -1 if < 0
+
+            //Unsatisfied: odd parity of the hard decisions, or of the incoming signs with sign_parity
+            if (arg->bitval)
+                _mm_store_si128((__m128i *)&arg->unsat[cw_block].v,
+                                _mm_or_si128(_mm_load_si128((__m128i *)&arg->unsat[cw_block].v), gather ? parity : sign));
+
+#pragma GCC unroll 32
+            for (int k = 0; k < deg; k++) {
+                mask = _mm_xor_si128(sign, _mm_cmplt_epi8(msg[k], zero)); //if sign*msg < 0 =>0xFF, else 0x00
+                mask = _mm_or_si128(mask, one);
+                absol = VEC_BLEND(cMinLLR, cNMinLLR, _mm_cmpeq_epi8(_mm_abs_epi8(msg[k]), minLLR));
+                _mm_store_si128((__m128i *)&emsg[k].message[cw_block].v, _mm_sign_epi8(absol, mask));
+            }
+        }
+    }
+}
+
+/* Check node update of rows of any degree, following the row links */
+static inline __attribute__((always_inline)) void sse_ldpc_cn_rows_generic(struct cn_update_args *arg, int first, int num, const ldpc_algorithm_t algorithm) {
+    __m128i minLLR, nMinLLR, absol, minMsg,tmp1, tmp2, mask1, mask2, mask3, msg, sign, zero, parity;
+    const __m128i offset = _mm_set1_epi8(arg->offset);
+    const __m128i alpha = _mm_set1_epi16(arg->alpha);
+    const int gather = arg->bitval && !arg->sign_parity;
 
     int row_start;
     char counter;
-    unsigned short iter = 0;
 
-    struct cn_update_args *arg;
-    arg = (struct cn_update_args *)threadarg;
+    for (int i = first; i < first + num; i++) {
+        for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS;cw_block++) {
+            if (arg->active && !arg->active[cw_block])
+                continue;
+            minLLR = _mm_set1_epi8(127);
+            nMinLLR = _mm_set1_epi8(127);
+            minMsg = _mm_setzero_si128();
+            sign =  _mm_set1_epi8(1);
+            parity = _mm_setzero_si128();
+            counter = 0;
+
+            row_start = arg->row_idx[i];
+            int index = row_start;
 
-    while (iter++ < arg->max_iter)
-    {
-        pthread_barrier_wait(arg->barr_0);
-        for (int i=arg->first_n; i < arg->first_n + arg->num_n; i++) {
-            for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS;cw_block++) {
-                minLLR = _mm_set1_epi8(127);
-                nMinLLR = _mm_set1_epi8(127);
-                sign =  _mm_set1_epi8(1);
-                counter = 0;
+            do {
+                //msg = emsg[index].message[cw_block].b[cw];
+                msg = _mm_load_si128((__m128i *)&arg->emsg[index].message[cw_block].v);
 
-                row_start = arg->row_idx[i];
-                int index = row_start;
+                //Parity of the hard decisions of the previous bit node update
+                if (gather)
+                    parity = _mm_xor_si128(parity, _mm_load_si128((__m128i *)&arg->bitval[arg->llr_map[index]*LDPC_CODEWORD_BLOCKS + cw_block].v));
 
-                do {
-                    //msg = emsg[index].message[cw_block].b[cw];
-                    msg = _mm_load_si128((__m128i *)&arg->emsg[index].message[cw_block].v);
+                //sign *= (msg >= 0 ? 1:-1);
+                sign = _mm_xor_si128(sign, msg);
 
-                    //sign *= (msg >= 0 ? 1:-1);
-                    sign = _mm_xor_si128(sign, msg);
+                //abs(msg)
+                absol = _mm_abs_epi8(msg);
 
-                    //abs(msg)
-                    absol = _mm_abs_epi8(msg);
 
+                mask1 = _mm_cmplt_epi8(absol, minLLR); //0xFF if less than minLLR
+                mask2 = _mm_cmplt_epi8(absol, nMinLLR); //0xFF if less than nMinLLR
 
-                    mask1 = _mm_cmplt_epi8(absol, minLLR); //0xFF if less than minLLR
-                    mask2 = _mm_cmplt_epi8(absol, nMinLLR); //0xFF if less than nMinLLR
+                tmp1 = VEC_BLEND(absol, minLLR, mask1);
+                nMinLLR = VEC_BLEND(nMinLLR, tmp1, mask2);
 
-                    tmp1 = VEC_BLEND(absol, minLLR, mask1);
-                    nMinLLR = VEC_BLEND(nMinLLR, tmp1, mask2);
+                minLLR = VEC_BLEND(minLLR, absol, mask1);
 
-                    minLLR = VEC_BLEND(minLLR, absol, mask1);
+                tmp1 = _mm_set1_epi8(counter);
+                minMsg = VEC_BLEND(minMsg, tmp1, mask1);
 
-                    tmp1 = _mm_set1_epi8(counter);
-                    minMsg = VEC_BLEND(minMsg, tmp1, mask1);
+                index = arg->hb[index].i_next;
+                counter++;
+            } while (index != row_start);
 
-                    index = arg->hb[index].i_next;
-                    counter++;
-                } while (index != row_start);
+            sse_ldpc_cn_correct(&minLLR, &nMinLLR, offset, alpha, algorithm);
 
-                counter = 0;
-                zero = _mm_setzero_si128();
-                sign = _mm_cmplt_epi8(sign,zero); //0xFF = -1 if < 0
+            counter = 0;
+            zero = _mm_setzero_si128();
+            sign = _mm_cmplt_epi8(sign,zero); //0xFF = -1 if < 0
 
-                do {
-                    msg = _mm_load_si128((__m128i *)&arg->emsg[index].message[cw_block].v);
+            //Unsatisfied: odd parity of the hard decisions, or of the incoming signs with sign_parity
+            if (arg->bitval)
+                _mm_store_si128((__m128i *)&arg->unsat[cw_block].v,
+                                _mm_or_si128(_mm_load_si128((__m128i *)&arg->unsat[cw_block].v), gather ? parity : sign));
 
-                    mask1 = _mm_cmpeq_epi8(minMsg, _mm_set1_epi8(counter));
-                    mask2 = _mm_cmplt_epi8(msg, zero);
-                    mask3 = _mm_xor_si128(sign, mask2); //if sign*msg < 0 =>0xFF, else 0x00
-                    mask3 = _mm_or_si128(mask3, _mm_set1_epi8(1));
-                    tmp1 = _mm_sign_epi8(minLLR, mask3);
-                    tmp2 = _mm_sign_epi8(nMinLLR, mask3);
+            do {
+                msg = _mm_load_si128((__m128i *)&arg->emsg[index].message[cw_block].v);
 
-                    msg = VEC_BLEND(tmp1, tmp2, mask1);
+                mask1 = _mm_cmpeq_epi8(minMsg, _mm_set1_epi8(counter));
+                mask2 = _mm_cmplt_epi8(msg, zero);
+                mask3 = _mm_xor_si128(sign, mask2); //if sign*msg < 0 =>0xFF, else 0x00
+                mask3 = _mm_or_si128(mask3, _mm_set1_epi8(1));
+                tmp1 = _mm_sign_epi8(minLLR, mask3);
+                tmp2 = _mm_sign_epi8(nMinLLR, mask3);
 
-                    _mm_store_si128((__m128i *)&arg->emsg[index].message[cw_block].v, msg);
-                    index = arg->hb[index].i_next;
-                    counter++;
-                } while (index != row_start);
-            }
+                msg = VEC_BLEND(tmp1, tmp2, mask1);
+
+                _mm_store_si128((__m128i *)&arg->emsg[index].message[cw_block].v, msg);
+                index = arg->hb[index].i_next;
+                counter++;
+            } while (index != row_start);
         }
-        pthread_barrier_wait(arg->barr_1);
     }
+}
+
+/* One check node update of the rows of a thread. The algorithm argument is always
+ * a compile-time constant, so each of the thread functions below gets its own
+ * specialized kernel without any runtime branching on the update rule. Within a
+ * kernel, each degree run is dispatched to the instance unrolled for its degree.
+ */
+static inline __attribute__((always_inline)) void sse_ldpc_cn_pass_kernel(struct cn_update_args *arg, const ldpc_algorithm_t algorithm) {
+    unsigned long long tsc;
+
+    if (arg->bitval)
+        for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS;cw_block++)
+            _mm_store_si128((__m128i *)&arg->unsat[cw_block].v, _mm_setzero_si128());
+
+    for (int r = 0; r < arg->num_runs; r++) {
+        ldpc_degree_run_t *run = &arg->runs[r];
+
+        tsc = __rdtsc();
+        switch (run->deg) {
+#define SSE_LDPC_CN_CASE(d) case d: sse_ldpc_cn_rows(arg, run->first_n, run->num_n, d, algorithm); break;
+        LDPC_UNROLLED_DEGREES(SSE_LDPC_CN_CASE)
+#undef SSE_LDPC_CN_CASE
+        default:
+            sse_ldpc_cn_rows_generic(arg, run->first_n, run->num_n, algorithm);
+            break;
+        }
+        arg->degree_cycles[IMIN(run->deg, LDPC_STATS_MAX_DEGREE - 1)] += __rdtsc() - tsc;
+    }
+}
+
+/* Check node update iterations of a thread */
+static inline __attribute__((always_inline)) void sse_ldpc_cn_update_kernel(struct cn_update_args *arg, const ldpc_algorithm_t algorithm) {
+    unsigned short iter = 0;
+    unsigned long long wait = 0;
+
+    while (iter++ < arg->max_iter)
+    {
+        sse_ldpc_barrier_wait(arg->barr_0, &wait);
+        sse_ldpc_cn_pass_kernel(arg, algorithm);
+        sse_ldpc_check_deadline(arg);
+        sse_ldpc_barrier_wait(arg->barr_1, &wait);
+
+        if (arg->conv_iter)
+            sse_ldpc_record_convergence(arg, iter);
+        if (*arg->stop)
+            break;
+        if (arg->bitval && sse_ldpc_all_satisfied(arg->unsat_all, arg->num_threads))
+            break;
+    }
+
+    *arg->wait_cycles += wait;
+}
+
+void *sse_ldpc_ms_cn_update(void *threadarg) {
+    sse_ldpc_cn_update_kernel((struct cn_update_args *)threadarg, LDPC_MIN_SUM);
+    return NULL;
+}
 
-    pthread_exit(NULL);
+void *sse_ldpc_oms_cn_update(void *threadarg) {
+    sse_ldpc_cn_update_kernel((struct cn_update_args *)threadarg, LDPC_OFFSET_MIN_SUM);
+    return NULL;
+}
+
+void *sse_ldpc_nms_cn_update(void *threadarg) {
+    sse_ldpc_cn_update_kernel((struct cn_update_args *)threadarg, LDPC_NORMALIZED_MIN_SUM);
+    return NULL;
+}
+
+void sse_ldpc_ms_cn_pass(struct cn_update_args *arg) {
+    sse_ldpc_cn_pass_kernel(arg, LDPC_MIN_SUM);
+}
+
+void sse_ldpc_oms_cn_pass(struct cn_update_args *arg) {
+    sse_ldpc_cn_pass_kernel(arg, LDPC_OFFSET_MIN_SUM);
+}
 
+void sse_ldpc_nms_cn_pass(struct cn_update_args *arg) {
+    sse_ldpc_cn_pass_kernel(arg, LDPC_NORMALIZED_MIN_SUM);
 }
 
-void *sse_ldpc_ms_check_unsatisfied(void *threadarg) {
+/* Parity check of the hard decisions in bitval for the rows of one thread.
+ * Codewords with an unsatisfied check are flagged in the unsat mask.
+ */
+void sse_ldpc_check_unsatisfied(struct check_satisfied_args *arg) {
     __m128i hard_val;
     __m128i sum;
-    const __m128i zeros = _mm_setzero_si128();
+    __m128i unsat[LDPC_CODEWORD_BLOCKS];
 
     int row_start;
-    char unsatisfied = 0;
 
-    struct check_satisfied_args *arg;
-    arg = (struct check_satisfied_args *)threadarg;
+    for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS;cw_block++)
+        unsat[cw_block] = _mm_setzero_si128();
 
     for (int i=arg->first_n; i < arg->first_n + arg->num_n; i++) {
         row_start = arg->row_idx[i];
@@ -281,99 +656,561 @@ void *sse_ldpc_ms_check_unsatisfied(void *threadarg) {
 
                 index = arg->hb[index].i_next;
             } while (index != row_start);
-            if (! _mm_movemask_epi8(_mm_cmpeq_epi32(sum, zeros))) {
-                unsatisfied = 1;
-                goto unsat;
-            }
+
+            unsat[cw_block] = _mm_or_si128(unsat[cw_block], sum);
         }
     }
-    unsat:
-    arg->unsat_eq[0] = unsatisfied;
-    pthread_exit(NULL);
 
+    for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS;cw_block++)
+        _mm_store_si128((__m128i *)&arg->unsat[cw_block].v, unsat[cw_block]);
 }
 
-ldpc_t *ldpc_init_sse(ldpc_param_t *param)
+void sse_ldpc_record_convergence(struct cn_update_args *arg, unsigned short iter) {
+    ldpc_bit_t unsat;
+
+    *arg->iterations = iter;
+    if (!arg->bitval)
+        return;
+
+    for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS; cw_block++) {
+        __m128i acc = _mm_setzero_si128();
+        for (int t = 0; t < arg->num_threads; t++)
+            acc = _mm_or_si128(acc, _mm_load_si128((__m128i *)&arg->unsat_all[t*LDPC_CODEWORD_BLOCKS + cw_block].v));
+        _mm_store_si128((__m128i *)&unsat.v, acc);
+
+        /* The checked hard decisions were made before this iteration's check node update */
+        for (int k = 0; k < 16; k++) {
+            if (unsat.b[k])
+                arg->conv_iter[cw_block*16 + k] = LDPC_NOT_CONVERGED;
+            else if (arg->conv_iter[cw_block*16 + k] == LDPC_NOT_CONVERGED)
+                arg->conv_iter[cw_block*16 + k] = iter - 1;
+        }
+    }
+}
+
+/* Split the nodes first..first+num-1 into runs of equal degree, returns the number of runs */
+static int sse_ldpc_degree_runs(const int *deg, int first, int num, ldpc_degree_run_t *runs) {
+    int num_runs = 0;
+
+    for (int i = first; i < first + num; i++) {
+        if (num_runs == 0 || runs[num_runs-1].deg != deg[i]) {
+            runs[num_runs].first_n = i;
+            runs[num_runs].num_n = 0;
+            runs[num_runs].deg = deg[i];
+            num_runs++;
+        }
+        runs[num_runs-1].num_n++;
+    }
+
+    return num_runs;
+}
+
+/* Start the workers, unless decoding on the calling thread, and set up the barriers
+ * for num_threads threads per node type. Returns 0 on success and -1 otherwise.
+ */
+static int sse_ldpc_shared_init(sse_ldpc_shared_t *s, unsigned short num_threads, int workers) {
+    memset(s, 0, sizeof(sse_ldpc_shared_t));
+    s->num_threads = num_threads;
+    if (workers && !(s->pool = ldpc_pool_create(num_threads*2)))
+        return -1;
+    pthread_barrier_init(&s->barr_0, NULL, num_threads*2);
+    pthread_barrier_init(&s->barr_1, NULL, num_threads*2);
+    pthread_barrier_init(&s->barr_bv, NULL, num_threads);
+
+    return 0;
+}
+
+static void sse_ldpc_shared_destroy(sse_ldpc_shared_t *s) {
+    if (s->pool)
+        ldpc_pool_destroy(s->pool);
+    pthread_barrier_destroy(&s->barr_0);
+    pthread_barrier_destroy(&s->barr_1);
+    pthread_barrier_destroy(&s->barr_bv);
+    _mm_free(s->edge_msg);
+    _mm_free(s->llr_interl);
+    _mm_free(s->bitval_interl);
+    _mm_free(s->soft_interl);
+    free(s->rows);
+}
+
+/* Grow the scratch memory to fit the code of h. The contents are not kept, as they
+ * only live through one decode call.
+ */
+static void sse_ldpc_shared_reserve(sse_ldpc_shared_t *s, ldpc_t *h) {
+    size_t msg_bytes = h->num_edges*h->msg_size;
+    size_t llr_bytes = h->N*h->msg_size;
+    size_t bit_bytes = LDPC_CODEWORD_BLOCKS*h->N*sizeof(ldpc_bit_t);
+    size_t row_bytes = 16*h->in_len;
+
+    if (msg_bytes > s->msg_bytes) {
+        _mm_free(s->edge_msg);
+        s->edge_msg = (ldpc_msg_t *)_mm_malloc(msg_bytes, 64);
+        s->msg_bytes = msg_bytes;
+    }
+    if (llr_bytes > s->llr_bytes) {
+        _mm_free(s->llr_interl);
+        s->llr_interl = (ldpc_llr_t *)_mm_malloc(llr_bytes, 64); //64-byte to align with cache lines
+        s->llr_bytes = llr_bytes;
+    }
+    if (bit_bytes > s->bit_bytes) {
+        _mm_free(s->bitval_interl);
+        _mm_free(s->soft_interl);
+        s->bitval_interl = (ldpc_bit_t *)_mm_malloc(bit_bytes, 64);
+        s->soft_interl = (ldpc_llr_t *)_mm_malloc(bit_bytes, 64);
+        s->bit_bytes = bit_bytes;
+    }
+    if (row_bytes > s->row_bytes) {
+        free(s->rows);
+        s->rows = (char *)malloc(row_bytes);
+        s->row_bytes = row_bytes;
+    }
+}
+
+/* Point the thread arguments of h to the current scratch memory */
+static void sse_ldpc_attach_scratch(ldpc_t *h) {
+    h->edge_msg = h->shared->edge_msg;
+    for (int i = 0; i < h->num_threads; i++) {
+        h->bn_args[i].emsg = h->edge_msg;
+        h->bn_bv_args[i].emsg = h->edge_msg;
+        h->cn_args[i].emsg = h->edge_msg;
+    }
+}
+
+/* Build the decoder's tables from the code: renumber the nodes and link the edges of
+ * each row and column. h->K and h->in_len are already set. Returns 0 on success.
+ */
+static int sse_ldpc_build_tables(ldpc_t *h, ldpc_code_t *H, ldpc_reorder_t reorder, const char *known)
 {
-    ldpc_t *h;
-    ldpc_ll_edge_t *node;
-    int i, first_idx;
+    int i, k, first_idx, ret = -1;
+    int *row_order, *col_order, *col_pos, *edge_id;
+    int row_edges[LDPC_MAX_ROW_DEGREE], row_cols[LDPC_MAX_ROW_DEGREE];
+    int col_edges[LDPC_MAX_COL_DEGREE];
+
+    h->hb = (ldpc_edge_t *)_mm_malloc(H->num_edges * sizeof(ldpc_edge_t), 16);
+    h->hc = (ldpc_edge_t *)_mm_malloc(H->num_edges * sizeof(ldpc_edge_t), 16);
+    h->row_idx = (int *)_mm_malloc(H->M * sizeof(int), 16);
+    h->col_idx = (int *)_mm_malloc(H->N * sizeof(int), 16);
+    h->llr_map = (int *)_mm_malloc(H->num_edges * sizeof(int), 16);
+
+    /* Renumber the nodes, and number the edges in row order of the new node numbers.
+     * Within a row, the edges follow the new bit order, and each column links its
+     * edges in increasing order, so both node sweeps walk edge_msg forwards.
+     *
+     * Shortened bits are known to be zero, so their messages to the check nodes
+     * would be saturated and positive: they never hold the minimum magnitude and
+     * never change a sign. They are left out of the graph, together with any
+     * check node left without edges.
+     */
+    row_order = (int *)malloc(H->M * sizeof(int));
+    col_order = (int *)malloc(H->N * sizeof(int));
+    col_pos = (int *)malloc(H->N * sizeof(int));
+    edge_id = (int *)malloc(H->num_edges * sizeof(int));
+    if (ldpc_reorder(H, reorder, row_order, col_order))
+        goto cleanup;
+    for(i=0;i<H->N;i++) {
+        if (known[col_order[i]] == LDPC_BIT_SHORTENED) {
+            col_pos[col_order[i]] = -1;
+        } else {
+            col_pos[col_order[i]] = h->N;
+            col_order[h->N++] = col_order[i];
+        }
+    }
 
-    /* Set up LDPC code structures from supplied matrix */
-    if (param->h_matrix)
+    first_idx = 0;
+    for(i=0;i<H->M;i++)
     {
-        h = (ldpc_t *)calloc(1, sizeof(ldpc_t));
-        h->M = param->h_matrix->M;
-        h->N = param->h_matrix->N;
-        h->K = param->h_matrix->K;
-        h->num_edges = param->h_matrix->num_edges;
-
-        h->hb = (ldpc_edge_t *)_mm_malloc(h->num_edges * sizeof(ldpc_edge_t), 16);
-        h->hc = (ldpc_edge_t *)_mm_malloc(h->num_edges * sizeof(ldpc_edge_t), 16);
-        h->row_idx = (int *)_mm_malloc(h->M * sizeof(int), 16);
-        h->col_idx = (int *)_mm_malloc(h->N * sizeof(int), 16);
-        h->llr_map = (int *)_mm_malloc(h->num_edges * sizeof(int), 16);
-
-        for(i=0;i<h->M;i++)
-        {
-            node = param->h_matrix->rows[i];
-            first_idx = node->idx;
-            h->row_idx[i] = node->idx;
-            do {
-                if (node->right)
-                    h->hb[node->idx].i_next = node->right->idx;
-                else /* No further edges in row. Link back to first edge */
-                    h->hb[node->idx].i_next = first_idx;
+        int deg = 0, k;
+
+        for (int e = H->row_start[row_order[i]]; e < H->row_start[row_order[i]+1]; e++) {
+            int col = ldpc_code_index(H, H->row_col, e);
+
+            if (col_pos[col] < 0)
+                continue;
+            if (deg >= LDPC_MAX_ROW_DEGREE) {
+                fprintf(stderr, "Check node degree exceeds %d\n", LDPC_MAX_ROW_DEGREE);
+                goto cleanup;
+            }
+            /* Insertion sort by bit position, rows are short */
+            for (k = deg++; k > 0 && col_pos[row_cols[k-1]] > col_pos[col]; k--) {
+                row_edges[k] = row_edges[k-1];
+                row_cols[k] = row_cols[k-1];
+            }
+            row_edges[k] = e;
+            row_cols[k] = col;
+        }
+        if (deg == 0)
+            continue;
 
-                node = node->right;
-            } while (node);
+        h->row_idx[h->M++] = first_idx;
+        for (k = 0; k < deg; k++) {
+            edge_id[row_edges[k]] = first_idx + k;
+            h->hb[first_idx + k].i_next = first_idx + (k + 1) % deg;
         }
+        first_idx += deg;
+    }
+    h->num_edges = first_idx;
+
+    for(i=0;i<h->N;i++)
+    {
+        int deg = 0, k, e;
+
+        for (int j = H->col_start[col_order[i]]; j < H->col_start[col_order[i]+1]; j++) {
+            if (deg >= LDPC_MAX_COL_DEGREE) {
+                fprintf(stderr, "Bit node degree exceeds %d\n", LDPC_MAX_COL_DEGREE);
+                goto cleanup;
+            }
+            e = edge_id[ldpc_code_index(H, H->col_edge, j)];
+            for (k = deg++; k > 0 && col_edges[k-1] > e; k--)
+                col_edges[k] = col_edges[k-1];
+            col_edges[k] = e;
+        }
+
+        h->col_idx[i] = col_edges[0];
+        for (k = 0; k < deg; k++) {
+            h->hc[col_edges[k]].i_next = col_edges[(k + 1) % deg];
+            h->llr_map[col_edges[k]] = i;
+        }
+    }
+
+    /* Inputs and outputs are mapped between the bits of H and the decoder's order */
+    if (reorder != LDPC_REORDER_NONE || h->N != H->N || h->in_len != H->N) {
+        int *in_idx = edge_id; /* Input value of each bit of H */
+
+        for(i=0,k=0;i<H->N;i++)
+            in_idx[i] = known[i] ? -1 : k++;
 
+        h->bit_map = (int *)malloc(h->N * sizeof(int));
         for(i=0;i<h->N;i++)
-        {
-            node = param->h_matrix->cols[i];
-            first_idx = node->idx;
-            h->col_idx[i] = node->idx;
-            do {
-                if (node->down)
-                    h->hc[node->idx].i_next = node->down->idx;
-                else
-                    h->hc[node->idx].i_next = first_idx;
+            h->bit_map[i] = in_idx[col_order[i]];
+
+        h->bit_pos = (int *)malloc(h->N * sizeof(int));
+        for(i=0,k=0;i<H->N;i++)
+            if (col_pos[i] >= 0)
+                h->bit_pos[k++] = col_pos[i];
+    }
+
+    /* Gather schedule of the bit node update */
+    h->bn_edges = (int *)malloc(h->num_edges * sizeof(int));
+    h->bn_edge_start = (int *)malloc((h->N + 1) * sizeof(int));
+    h->bn_edge_start[0] = 0;
+    for (i = 0; i < h->N; i++) {
+        int index = h->col_idx[i], k = h->bn_edge_start[i];
+        do {
+            h->bn_edges[k++] = index;
+            index = h->hc[index].i_next;
+        } while (index != h->col_idx[i]);
+        h->bn_edge_start[i+1] = k;
+    }
+    ret = 0;
+
+cleanup:
+    free(row_order);
+    free(col_order);
+    free(col_pos);
+    free(edge_id);
+    return ret;
+}
+
+/* Number of the table format written by sse_ldpc_cache_store, part of the cache key */
+#define SSE_LDPC_CACHE_FORMAT 1
+#define SSE_LDPC_CACHE_SECTIONS 10
+
+/* Cache key of the tables built by sse_ldpc_build_tables */
+static uint64_t sse_ldpc_cache_key(const ldpc_code_t *H, ldpc_reorder_t reorder, const char *known)
+{
+    int dims[7] = { SSE_LDPC_CACHE_FORMAT, H->M, H->N, H->K, H->num_edges, H->index_size, reorder };
+    uint64_t key = ldpc_cache_hash(LDPC_CACHE_HASH_INIT, "sse", 3);
+
+    key = ldpc_cache_hash(key, dims, sizeof(dims));
+    key = ldpc_cache_hash(key, H->row_start, (H->M + 1) * sizeof(int));
+    key = ldpc_cache_hash(key, H->col_start, (H->N + 1) * sizeof(int));
+    key = ldpc_cache_hash(key, H->row_col, (size_t)H->num_edges * H->index_size);
+    key = ldpc_cache_hash(key, H->col_edge, (size_t)H->num_edges * H->index_size);
+    return ldpc_cache_hash(key, known, H->N);
+}
+
+/* Sections of the cached tables. The mapping is read-only, the tables are never
+ * written after they are built.
+ */
+static void sse_ldpc_cache_sections(ldpc_t *h, int *dims, ldpc_cache_section_t *s)
+{
+    size_t edges = (size_t)h->num_edges * sizeof(int);
+
+    s[0].data = dims;
+    s[0].size = 3 * sizeof(int);
+    s[1].data = h->hb;
+    s[1].size = edges;
+    s[2].data = h->hc;
+    s[2].size = edges;
+    s[3].data = h->row_idx;
+    s[3].size = h->M * sizeof(int);
+    s[4].data = h->col_idx;
+    s[4].size = h->N * sizeof(int);
+    s[5].data = h->llr_map;
+    s[5].size = edges;
+    s[6].data = h->bn_edges;
+    s[6].size = edges;
+    s[7].data = h->bn_edge_start;
+    s[7].size = (h->N + 1) * sizeof(int);
+    s[8].data = h->bit_map;
+    s[8].size = h->bit_map ? h->N * sizeof(int) : 0;
+    s[9].data = h->bit_pos;
+    s[9].size = h->bit_pos ? h->N * sizeof(int) : 0;
+}
+
+static void sse_ldpc_cache_store(ldpc_t *h, const char *dir, uint64_t key)
+{
+    ldpc_cache_section_t s[SSE_LDPC_CACHE_SECTIONS];
+    int dims[3] = { h->M, h->N, h->num_edges };
+
+    sse_ldpc_cache_sections(h, dims, s);
+    ldpc_cache_store(dir, "sse", key, s, SSE_LDPC_CACHE_SECTIONS);
+}
+
+/* Point the tables into the cache file of key, if there is a valid one. Returns 0 on success. */
+static int sse_ldpc_cache_load(ldpc_t *h, const char *dir, uint64_t key)
+{
+    ldpc_cache_section_t s[SSE_LDPC_CACHE_SECTIONS], expect[SSE_LDPC_CACHE_SECTIONS];
+    const int *dims;
+    void *map;
+    size_t map_size;
+
+    if (!(map = ldpc_cache_map(dir, "sse", key, s, SSE_LDPC_CACHE_SECTIONS, &map_size)))
+        return -1;
+    dims = (const int *)s[0].data;
+    if (s[0].size != 3 * sizeof(int))
+        goto invalid;
+    h->M = dims[0];
+    h->N = dims[1];
+    h->num_edges = dims[2];
+
+    h->hb = (ldpc_edge_t *)s[1].data;
+    h->hc = (ldpc_edge_t *)s[2].data;
+    h->row_idx = (int *)s[3].data;
+    h->col_idx = (int *)s[4].data;
+    h->llr_map = (int *)s[5].data;
+    h->bn_edges = (int *)s[6].data;
+    h->bn_edge_start = (int *)s[7].data;
+    h->bit_map = s[8].size ? (int *)s[8].data : NULL;
+    h->bit_pos = s[9].size ? (int *)s[9].data : NULL;
+
+    /* The key and checksum match, the sizes are only checked against the dimensions */
+    sse_ldpc_cache_sections(h, (int *)dims, expect);
+    for (int i = 0; i < SSE_LDPC_CACHE_SECTIONS; i++)
+        if (s[i].size != expect[i].size)
+            goto invalid;
+    if (h->M <= 0 || h->N <= 0 || h->bn_edge_start[h->N] != h->num_edges)
+        goto invalid;
+
+    h->cache_map = map;
+    h->cache_map_size = map_size;
+    return 0;
+
+invalid:
+    h->hb = h->hc = NULL;
+    h->row_idx = h->col_idx = h->llr_map = h->bn_edges = h->bn_edge_start = h->bit_map = h->bit_pos = NULL;
+    h->M = h->N = h->num_edges = 0;
+    ldpc_cache_unmap(map, map_size);
+    return -1;
+}
 
-                h->llr_map[node->idx] = i;
+/* Set up a decoder for the code in param. Without shared resources, the decoder
+ * gets its own, with as many threads as requested.
+ */
+static ldpc_t *sse_ldpc_create(ldpc_param_t *param, sse_ldpc_shared_t *shared)
+{
+    ldpc_t *h;
+    ldpc_code_t *H;
+    int i;
+    char *known;
+    int *row_deg, *col_deg;
+    uint64_t key = 0;
+
+    if (param->algorithm == LDPC_NORMALIZED_MIN_SUM && !(param->alpha > 0.0f && param->alpha <= 1.0f)) {
+        fprintf(stderr, "Normalized min-sum requires 0 < alpha <= 1\n");
+        return NULL;
+    }
 
-                node = node->down;
-            } while (node);
+    /* Set up LDPC code structures from supplied matrix */
+    if ((H = ldpc_param_code(param)))
+    {
+        /* Shortened and punctured bits of H */
+        known = (char *)calloc(H->N, sizeof(char));
+        for (i = 0; i < param->num_shortened + param->num_punctured; i++) {
+            int bit = i < param->num_shortened ? param->shortened[i] : param->punctured[i - param->num_shortened];
+            char type = i < param->num_shortened ? LDPC_BIT_SHORTENED : LDPC_BIT_PUNCTURED;
+
+            if (bit < 0 || bit >= H->N || (known[bit] && known[bit] != type)) {
+                fprintf(stderr, "Invalid shortened or punctured bit %d\n", bit);
+                free(known);
+                return NULL;
+            }
+            known[bit] = type;
         }
 
+        h = (ldpc_t *)calloc(1, sizeof(ldpc_t));
+        h->M = 0;
+        h->N = 0;
+        h->K = 0;
+        h->in_len = 0;
+        h->soft_len = 0;
+        for (i = 0; i < H->N; i++) {
+            if (known[i] != LDPC_BIT_SHORTENED) {
+                h->K += i < H->K;
+                h->soft_len++;
+            }
+            h->in_len += !known[i];
+        }
+        if (!param->soft_output_parity)
+            h->soft_len = h->K;
+
+        if (param->cache_dir)
+            key = sse_ldpc_cache_key(H, param->reorder, known);
+        if (!param->cache_dir || sse_ldpc_cache_load(h, param->cache_dir, key)) {
+            if (sse_ldpc_build_tables(h, H, param->reorder, known)) {
+                free(known);
+                ldpc_destroy_sse(h);
+                return NULL;
+            }
+            if (param->cache_dir)
+                sse_ldpc_cache_store(h, param->cache_dir, key);
+        }
+        free(known);
+
     } else {
         fprintf(stderr, "No LDPC code supplied!\n");
         return NULL;
     }
 
-    /* num_threads should divide both N and M */
-    h->num_threads = CLAMP(param->num_threads, 1, h->M); /* num_threads must be between 1 and M */
-    while (h->M % h->num_threads != 0 || h->N % h->num_threads != 0)
-        --h->num_threads;
-
-    fprintf(stderr, "Using %d simultaneous threads\n", h->num_threads);
+    if (shared) {
+        /* The last thread takes the nodes left over when the engine's threads do not divide M and N */
+        h->num_threads = shared->num_threads;
+        if (h->M < h->num_threads || h->N < h->num_threads) {
+            fprintf(stderr, "Code with M=%d, N=%d is too small for %d threads\n", h->M, h->N, h->num_threads);
+            ldpc_destroy_sse(h);
+            return NULL;
+        }
+    } else {
+        /* num_threads should divide both N and M */
+        h->num_threads = CLAMP(param->num_threads, 1, IMIN(h->M, LDPC_MAX_NUM_THREADS)); /* num_threads must be between 1 and M */
+        while (h->M % h->num_threads != 0 || h->N % h->num_threads != 0)
+            --h->num_threads;
+
+        if (param->num_threads)
+            fprintf(stderr, "Using %d simultaneous threads\n", h->num_threads);
+        else
+            fprintf(stderr, "Decoding on the calling thread\n");
+        shared = (sse_ldpc_shared_t *)malloc(sizeof(sse_ldpc_shared_t));
+        if (sse_ldpc_shared_init(shared, h->num_threads, param->num_threads != 0)) {
+            free(shared);
+            ldpc_destroy_sse(h);
+            return NULL;
+        }
+        h->own_shared = 1;
+    }
+    h->shared = shared;
+    h->stats.num_threads = h->num_threads;
 
     /* Allocate decoder memory */
-    h->edge_msg = (ldpc_msg_t *)_mm_malloc(h->num_edges * sizeof(ldpc_msg_t), 64);
+    h->precision = param->precision == LDPC_PRECISION_16 ? LDPC_PRECISION_16 : LDPC_PRECISION_8;
+    h->msg_size = h->precision == LDPC_PRECISION_16 ? sizeof(ldpc_msg16_t) : sizeof(ldpc_msg_t);
 
     h->bn_args = (struct bn_update_args *)malloc(h->num_threads*sizeof(struct bn_update_args));
     h->bn_bv_args = (struct bn_update_bitval_args *)malloc(h->num_threads*sizeof(struct bn_update_bitval_args));
     h->cn_args = (struct cn_update_args *)malloc(h->num_threads*sizeof(struct cn_update_args));
     h->cs_args = (struct check_satisfied_args *)malloc(h->num_threads*sizeof(struct check_satisfied_args));
 
-    h->unsatisfied_eqs = (char *)_mm_malloc(h->num_threads * sizeof(char), 16);
-    h->max_iter = CLAMP(param->max_iter, 0, 100);
+    h->unsat = (ldpc_bit_t *)_mm_malloc(h->num_threads*LDPC_CODEWORD_BLOCKS*sizeof(ldpc_bit_t), 64);
+
+    h->bf_max_iter = param->bf_max_iter;
+    h->bf_threshold = param->bf_threshold;
+    if (h->bf_max_iter) {
+        int max_deg = 0;
+
+        h->edge_row = (int *)_mm_malloc(h->num_edges * sizeof(int), 16);
+        for (i = 0; i < h->M; i++) {
+            int index = h->row_idx[i];
+            do {
+                h->edge_row[index] = i;
+                index = h->hb[index].i_next;
+            } while (index != h->row_idx[i]);
+        }
+        for (i = 0; i < h->N; i++) {
+            int deg = 0, index = h->col_idx[i];
+            do {
+                deg++;
+                index = h->hc[index].i_next;
+            } while (index != h->col_idx[i]);
+            max_deg = IMAX(max_deg, deg);
+        }
+        for (h->bf_bits = 1; (1 << h->bf_bits) <= max_deg; h->bf_bits++);
 
-    h->barr_0 = malloc(sizeof(pthread_barrier_t));
-    h->barr_1 = malloc(sizeof(pthread_barrier_t));
-    pthread_barrier_init(h->barr_0, NULL, h->num_threads*2);
-    pthread_barrier_init(h->barr_1, NULL, h->num_threads*2);
+        h->bf_hard = (__m128i *)_mm_malloc(h->N * sizeof(__m128i), 64);
+        h->bf_weak = (__m128i *)_mm_malloc(h->N * LDPC_BF_LEVELS * sizeof(__m128i), 64);
+        h->bf_synd = (__m128i *)_mm_malloc(h->M * sizeof(__m128i), 64);
+        h->bf_saved = (ldpc_bit_t *)_mm_malloc(h->N * sizeof(ldpc_bit_t), 64);
+    }
+    h->max_iter = CLAMP(param->max_iter, 0, 100);
+    h->deadline_us = param->deadline_us;
+    h->iter_budget = param->iter_budget;
+    h->iter_budget_max = param->iter_budget_max ? param->iter_budget_max : h->max_iter;
+    h->early_termination = param->early_termination;
+    h->sign_parity = param->sign_parity;
+
+    h->llr_scaling = param->llr_scaling;
+    h->llr_scale = param->llr_scale;
+    h->llr_target = param->llr_target;
+
+    h->soft_output = param->soft_output;
+
+    if (h->precision == LDPC_PRECISION_16) {
+        h->bn_update = sse16_ldpc_ms_bn_update;
+        h->bn_update_bitval = sse16_ldpc_ms_bn_update_bitval;
+        h->bn_pass = sse16_ldpc_bn_pass;
+        switch (param->algorithm) {
+        case LDPC_OFFSET_MIN_SUM:
+            h->cn_update = sse16_ldpc_oms_cn_update;
+            h->cn_pass = sse16_ldpc_oms_cn_pass;
+            break;
+        case LDPC_NORMALIZED_MIN_SUM:
+            h->cn_update = sse16_ldpc_nms_cn_update;
+            h->cn_pass = sse16_ldpc_nms_cn_pass;
+            break;
+        default:
+            h->cn_update = sse16_ldpc_ms_cn_update;
+            h->cn_pass = sse16_ldpc_ms_cn_pass;
+            break;
+        }
+    } else {
+        h->bn_update = sse_ldpc_ms_bn_update;
+        h->bn_update_bitval = sse_ldpc_ms_bn_update_bitval;
+        h->bn_pass = sse_ldpc_bn_pass;
+        switch (param->algorithm) {
+        case LDPC_OFFSET_MIN_SUM:
+            h->cn_update = sse_ldpc_oms_cn_update;
+            h->cn_pass = sse_ldpc_oms_cn_pass;
+            break;
+        case LDPC_NORMALIZED_MIN_SUM:
+            h->cn_update = sse_ldpc_nms_cn_update;
+            h->cn_pass = sse_ldpc_nms_cn_pass;
+            break;
+        default:
+            h->cn_update = sse_ldpc_ms_cn_update;
+            h->cn_pass = sse_ldpc_ms_cn_pass;
+            break;
+        }
+    }
 
+    row_deg = (int *)malloc(h->M * sizeof(int));
+    col_deg = (int *)malloc(h->N * sizeof(int));
+    for (i = 0; i < h->M; i++)
+        row_deg[i] = (i + 1 < h->M ? h->row_idx[i+1] : h->num_edges) - h->row_idx[i];
+    for (i = 0; i < h->N; i++)
+        col_deg[i] = h->bn_edge_start[i+1] - h->bn_edge_start[i];
+    h->cn_runs = (ldpc_degree_run_t *)malloc(h->M * sizeof(ldpc_degree_run_t));
+    h->bn_runs = (ldpc_degree_run_t *)malloc(h->N * sizeof(ldpc_degree_run_t));
+    h->cn_degree_cycles = calloc(h->num_threads, sizeof(*h->cn_degree_cycles));
+    h->bn_degree_cycles = calloc(h->num_threads, sizeof(*h->bn_degree_cycles));
 
     for(int i=0; i<h->num_threads; i++) {
         int first, num;
@@ -387,9 +1224,19 @@ ldpc_t *ldpc_init_sse(ldpc_param_t *param)
         h->bn_args[i].N = h->N;
         h->bn_args[i].emsg = h->edge_msg;
         h->bn_args[i].col_idx = h->col_idx;
+        h->bn_args[i].edges = h->bn_edges;
+        h->bn_args[i].edge_start = h->bn_edge_start;
+        h->bn_args[i].prefetch = param->prefetch_distance;
         h->bn_args[i].max_iter = h->max_iter;
-        h->bn_args[i].barr_0 = h->barr_0;
-        h->bn_args[i].barr_1 = h->barr_1;
+        h->bn_args[i].unsat_all = h->unsat;
+        h->bn_args[i].num_threads = h->num_threads;
+        h->bn_args[i].wait_cycles = &h->stats.bn_wait_cycles[i];
+        h->bn_args[i].runs = &h->bn_runs[first];
+        h->bn_args[i].num_runs = sse_ldpc_degree_runs(col_deg, first, num, &h->bn_runs[first]);
+        h->bn_args[i].degree_cycles = h->bn_degree_cycles[i];
+        h->bn_args[i].stop = &h->stop;
+        h->bn_args[i].barr_0 = &h->shared->barr_0;
+        h->bn_args[i].barr_1 = &h->shared->barr_1;
 
         h->bn_bv_args[i].first_n = first;
         h->bn_bv_args[i].num_n = num;
@@ -397,6 +1244,10 @@ ldpc_t *ldpc_init_sse(ldpc_param_t *param)
         h->bn_bv_args[i].N = h->N;
         h->bn_bv_args[i].emsg = h->edge_msg;
         h->bn_bv_args[i].col_idx = h->col_idx;
+        h->bn_bv_args[i].extrinsic = h->soft_output == LDPC_SOFT_EXTRINSIC;
+        h->bn_bv_args[i].cs = &h->cs_args[i];
+        h->bn_bv_args[i].wait_cycles = &h->stats.bn_wait_cycles[i];
+        h->bn_bv_args[i].barr = &h->shared->barr_bv;
 
         num = h->M/h->num_threads;
         first = i*num;
@@ -409,28 +1260,59 @@ ldpc_t *ldpc_init_sse(ldpc_param_t *param)
         h->cn_args[i].emsg = h->edge_msg;
         h->cn_args[i].row_idx = h->row_idx;
         h->cn_args[i].max_iter = h->max_iter;
-        h->cn_args[i].barr_0 = h->barr_0;
-        h->cn_args[i].barr_1 = h->barr_1;
+        h->cn_args[i].offset = CLAMP(param->offset, 0, 127);
+        h->cn_args[i].alpha = (unsigned short)(param->alpha*128.0f + 0.5f);
+        h->cn_args[i].llr_map = h->llr_map;
+        h->cn_args[i].unsat = &h->unsat[i*LDPC_CODEWORD_BLOCKS];
+        h->cn_args[i].unsat_all = h->unsat;
+        h->cn_args[i].num_threads = h->num_threads;
+        h->cn_args[i].conv_iter = i == 0 ? h->conv_iter : NULL;
+        h->cn_args[i].iterations = i == 0 ? &h->iterations : NULL;
+        h->cn_args[i].deadline = NULL;
+        h->cn_args[i].wait_cycles = &h->stats.cn_wait_cycles[i];
+        h->cn_args[i].runs = &h->cn_runs[first];
+        h->cn_args[i].num_runs = sse_ldpc_degree_runs(row_deg, first, num, &h->cn_runs[first]);
+        h->cn_args[i].degree_cycles = h->cn_degree_cycles[i];
+        h->cn_args[i].stop = &h->stop;
+        h->cn_args[i].barr_0 = &h->shared->barr_0;
+        h->cn_args[i].barr_1 = &h->shared->barr_1;
 
         h->cs_args[i].first_n = first;
         h->cs_args[i].num_n = num;
         h->cs_args[i].M = h->M;
         h->cs_args[i].llr_map = h->llr_map;
         h->cs_args[i].row_idx = h->row_idx;
-        h->cs_args[i].unsat_eq = &h->unsatisfied_eqs[i];
+        h->cs_args[i].unsat = &h->unsat[i*LDPC_CODEWORD_BLOCKS];
         h->cs_args[i].hb = h->hb;
     }
+    free(row_deg);
+    free(col_deg);
+
+    sse_ldpc_shared_reserve(h->shared, h);
+    sse_ldpc_attach_scratch(h);
 
     return h;
 }
 
+ldpc_t *ldpc_init_sse(ldpc_param_t *param)
+{
+    return sse_ldpc_create(param, NULL);
+}
+
 void ldpc_destroy_sse(ldpc_t *h) {
-   _mm_free(h->hb);
-   _mm_free(h->hc);
-   _mm_free(h->edge_msg);
-   _mm_free(h->row_idx);
-   _mm_free(h->col_idx);
-   _mm_free(h->llr_map);
+   if (h->cache_map) {
+       ldpc_cache_unmap(h->cache_map, h->cache_map_size);
+   } else {
+       _mm_free(h->hb);
+       _mm_free(h->hc);
+       _mm_free(h->row_idx);
+       _mm_free(h->col_idx);
+       _mm_free(h->llr_map);
+       free(h->bn_edges);
+       free(h->bn_edge_start);
+       free(h->bit_map);
+       free(h->bit_pos);
+   }
 
    /* Free thread data */
    free(h->bn_args);
@@ -438,137 +1320,1064 @@ void ldpc_destroy_sse(ldpc_t *h) {
    free(h->cn_args);
    free(h->cs_args);
 
-   free(h->barr_0);
-   free(h->barr_1);
+   _mm_free(h->unsat);
+
+   free(h->cn_runs);
+   free(h->bn_runs);
+   free(h->cn_degree_cycles);
+   free(h->bn_degree_cycles);
+
+   if (h->bf_max_iter) {
+       _mm_free(h->edge_row);
+       _mm_free(h->bf_hard);
+       _mm_free(h->bf_weak);
+       _mm_free(h->bf_synd);
+       _mm_free(h->bf_saved);
+   }
+
+   if (h->own_shared) {
+       sse_ldpc_shared_destroy(h->shared);
+       free(h->shared);
+   }
 
    free(h);
 }
 
-int ldpc_decode_sse(ldpc_t *h, char *llr, unsigned char *bitval) {
-    ldpc_llr_t *llr_interl;
-    ldpc_bit_t *bitval_interl;
+/* Input value of decoder position i of one codeword, zero for punctured bits */
+static inline char sse_ldpc_input(ldpc_t *h, const char *llr, int i) {
+    if (!h->bit_map)
+        return llr[i];
+    return h->bit_map[i] < 0 ? 0 : llr[h->bit_map[i]];
+}
+
+/* Interleave 8-bit LLRs of 128 codewords into the SIMD layout */
+static void sse_ldpc_interleave(ldpc_t *h, char *llr, ldpc_llr_t *llr_interl) {
+    if (h->precision == LDPC_PRECISION_16) {
+        ldpc_llr16_t *llr16_interl = (ldpc_llr16_t *)llr_interl;
+
+        for(int i = 0; i < h->N;i++) {
+            for (int n=0;n<LDPC_CODEWORD_BLOCKS_16;n++)  {
+                for (int k=0;k<8;k++) {
+                    llr16_interl[i*LDPC_CODEWORD_BLOCKS_16+n].b[k] = sse_ldpc_input(h, llr + (8*n + k)*h->in_len, i);
+                }
+            }
+        }
+    } else {
+        for(int i = 0; i < h->N;i++) {
+            for (int n=0;n<LDPC_CODEWORD_BLOCKS;n++)  {
+                for (int k=0;k<16;k++) {
+                    llr_interl[i*LDPC_CODEWORD_BLOCKS+n].b[k] = sse_ldpc_input(h, llr + (16*n + k)*h->in_len, i);
+                }
+            }
+        }
+    }
+}
+
+/* Quantization factor for one codeword of float LLRs */
+static float sse_ldpc_frame_scale(ldpc_t *h, const float *llr) {
+    const __m128 absmask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 acc = _mm_setzero_ps();
+    float sum[4];
+    float mean;
+    int i;
+
+    if (h->llr_scaling != LDPC_LLR_SCALE_ADAPTIVE)
+        return h->llr_scale;
+
+    for (i = 0; i + 4 <= h->in_len; i += 4)
+        acc = _mm_add_ps(acc, _mm_and_ps(_mm_loadu_ps(llr + i), absmask));
+    _mm_storeu_ps(sum, acc);
+    mean = sum[0] + sum[1] + sum[2] + sum[3];
+    for (; i < h->in_len; i++)
+        mean += fabsf(llr[i]);
+    mean /= h->in_len;
+
+    return mean > 0.0f ? h->llr_target / mean : h->llr_scale;
+}
+
+/* Float input value of decoder position i of one codeword, zero for punctured bits */
+static inline float sse_ldpc_input_f(const float *llr, const int *map, int i) {
+    if (!map)
+        return llr[i];
+    return map[i] < 0 ? 0.0f : llr[map[i]];
+}
+
+/* Scale and round the float LLRs of bits i..i+3 of one codeword, gathered through map if set */
+static inline __m128i sse_ldpc_quantize_ps(const float *llr, const int *map, int i, __m128 scale) {
+    __m128 v = map ? _mm_setr_ps(sse_ldpc_input_f(llr, map, i), sse_ldpc_input_f(llr, map, i+1),
+                                 sse_ldpc_input_f(llr, map, i+2), sse_ldpc_input_f(llr, map, i+3))
+                   : _mm_loadu_ps(llr + i);
+
+    return _mm_cvtps_epi32(_mm_mul_ps(v, scale));
+}
+
+/* Transpose four vectors of 32-bit elements */
+static inline void sse_ldpc_transpose4_epi32(__m128i *v) {
+    __m128i t0 = _mm_unpacklo_epi32(v[0], v[1]);
+    __m128i t1 = _mm_unpacklo_epi32(v[2], v[3]);
+    __m128i t2 = _mm_unpackhi_epi32(v[0], v[1]);
+    __m128i t3 = _mm_unpackhi_epi32(v[2], v[3]);
+
+    v[0] = _mm_unpacklo_epi64(t0, t1);
+    v[1] = _mm_unpackhi_epi64(t0, t1);
+    v[2] = _mm_unpacklo_epi64(t2, t3);
+    v[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+/* Quantize float LLRs of 128 codewords and interleave them into the SIMD layout.
+ * Four bit positions are handled at a time: the codewords of a block are quantized
+ * four bits at a time, packed with saturation, and transposed in registers.
+ */
+static void sse_ldpc_interleave_float(ldpc_t *h, float *llr, float *frame_scale, ldpc_llr_t *llr_interl) {
+    __m128 scale[128];
+    __m128i v[4], e[4];
+    int i, j, n, g, k, cw;
+
+    for (cw = 0; cw < 128; cw++)
+        scale[cw] = _mm_set1_ps(frame_scale ? frame_scale[cw] : sse_ldpc_frame_scale(h, llr + cw*h->in_len));
+
+    if (h->precision == LDPC_PRECISION_16) {
+        /* Group the four bits of two codewords: [a0 b0 a1 b1 a2 b2 a3 b3] */
+        const __m128i group = _mm_setr_epi8(0,1,8,9, 2,3,10,11, 4,5,12,13, 6,7,14,15);
+        const __m128i floor = _mm_set1_epi16(-32767);
+        ldpc_llr16_t *llr16_interl = (ldpc_llr16_t *)llr_interl;
+
+        for (n = 0; n < LDPC_CODEWORD_BLOCKS_16; n++) {
+            for (i = 0; i + 4 <= h->N; i += 4) {
+                for (g = 0; g < 4; g++) {
+                    cw = 8*n + 2*g;
+                    v[g] = _mm_packs_epi32(sse_ldpc_quantize_ps(llr + cw*h->in_len, h->bit_map, i, scale[cw]),
+                                           sse_ldpc_quantize_ps(llr + (cw+1)*h->in_len, h->bit_map, i, scale[cw+1]));
+                    v[g] = _mm_shuffle_epi8(_mm_max_epi16(v[g], floor), group);
+                }
+                sse_ldpc_transpose4_epi32(v);
+                for (j = 0; j < 4; j++)
+                    _mm_store_si128((__m128i *)&llr16_interl[(i+j)*LDPC_CODEWORD_BLOCKS_16 + n].v, v[j]);
+            }
+            for (; i < h->N; i++)
+                for (k = 0; k < 8; k++)
+                    llr16_interl[i*LDPC_CODEWORD_BLOCKS_16 + n].b[k] = (short)CLAMP(lrintf(sse_ldpc_input_f(llr + (8*n + k)*h->in_len, h->bit_map, i)*_mm_cvtss_f32(scale[8*n + k])), -32767, 32767);
+        }
+    } else {
+        /* Group the four bits of four codewords: [a0 b0 c0 d0 a1 b1 c1 d1 ...] */
+        const __m128i group = _mm_setr_epi8(0,4,8,12, 1,5,9,13, 2,6,10,14, 3,7,11,15);
+        const __m128i floor = _mm_set1_epi16(-127);
+
+        for (n = 0; n < LDPC_CODEWORD_BLOCKS; n++) {
+            for (i = 0; i + 4 <= h->N; i += 4) {
+                for (g = 0; g < 4; g++) {
+                    for (j = 0; j < 4; j++) {
+                        cw = 16*n + 4*g + j;
+                        e[j] = sse_ldpc_quantize_ps(llr + cw*h->in_len, h->bit_map, i, scale[cw]);
+                    }
+                    /* Saturate to [-127, 127] as 16-bit, then pack to 8-bit */
+                    e[0] = _mm_max_epi16(_mm_packs_epi32(e[0], e[1]), floor);
+                    e[2] = _mm_max_epi16(_mm_packs_epi32(e[2], e[3]), floor);
+                    v[g] = _mm_shuffle_epi8(_mm_packs_epi16(e[0], e[2]), group);
+                }
+                sse_ldpc_transpose4_epi32(v);
+                for (j = 0; j < 4; j++)
+                    _mm_store_si128((__m128i *)&llr_interl[(i+j)*LDPC_CODEWORD_BLOCKS + n].v, v[j]);
+            }
+            for (; i < h->N; i++)
+                for (k = 0; k < 16; k++)
+                    llr_interl[i*LDPC_CODEWORD_BLOCKS + n].b[k] = (char)CLAMP(lrintf(sse_ldpc_input_f(llr + (16*n + k)*h->in_len, h->bit_map, i)*_mm_cvtss_f32(scale[16*n + k])), -127, 127);
+        }
+    }
+}
+
+/* Byte shuffles and multipliers expanding 16 packed LLRs of one width, see sse_ldpc_unpack16 */
+typedef struct {
+    __m128i shuf_lo; /* Bytes holding values 0..7, one pair per 16-bit lane */
+    __m128i shuf_hi; /* Bytes holding values 8..15 */
+    __m128i mul; /* Moves each value to the top bits of its lane */
+    __m128i shift; /* Arithmetic shift back down, sign-extending the value */
+} sse_ldpc_unpack_t;
+
+static void sse_ldpc_unpack_setup(sse_ldpc_unpack_t *u, int bits) {
+    char lo[16], hi[16];
+    short mul[8];
+
+    for (int j = 0; j < 8; j++) {
+        int o = j*bits/8, s = j*bits%8;
+
+        /* Values 8..15 start bits bytes further. A value within one byte takes none of the next. */
+        lo[2*j] = o;
+        hi[2*j] = bits + o;
+        lo[2*j+1] = s + bits > 8 ? o + 1 : -128;
+        hi[2*j+1] = s + bits > 8 ? bits + o + 1 : -128;
+        mul[j] = 1 << (16 - s - bits);
+    }
+    u->shuf_lo = _mm_loadu_si128((__m128i *)lo);
+    u->shuf_hi = _mm_loadu_si128((__m128i *)hi);
+    u->mul = _mm_loadu_si128((__m128i *)mul);
+    u->shift = _mm_cvtsi32_si128(16 - bits);
+}
+
+/* Expand the 16 packed LLRs in the 2*bits bytes at p to 8-bit values. Reads 16 bytes. */
+static inline __m128i sse_ldpc_unpack16(const sse_ldpc_unpack_t *u, const unsigned char *p) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    __m128i lo = _mm_sra_epi16(_mm_mullo_epi16(_mm_shuffle_epi8(v, u->shuf_lo), u->mul), u->shift);
+    __m128i hi = _mm_sra_epi16(_mm_mullo_epi16(_mm_shuffle_epi8(v, u->shuf_hi), u->mul), u->shift);
+
+    return _mm_packs_epi16(lo, hi);
+}
+
+/* Packed LLR i of a codeword */
+static inline char sse_ldpc_packed_value(const unsigned char *p, int bits, int i) {
+    int pos = i*bits, s = pos & 7;
+    int v = p[pos >> 3] >> s;
+
+    if (s + bits > 8)
+        v |= p[(pos >> 3) + 1] << (8 - s);
+    v &= (1 << bits) - 1;
 
-    START_CLOCK(1);
+    return (v ^ (1 << (bits - 1))) - (1 << (bits - 1));
+}
+
+/* Expand one codeword of stride bytes of packed LLRs to one 8-bit value each */
+static void sse_ldpc_unpack(const sse_ldpc_unpack_t *u, const unsigned char *packed, size_t stride, int bits, int len, char *llr) {
+    int i;
+
+    for (i = 0; i + 16 <= len && (size_t)(i/8*bits + 16) <= stride; i += 16)
+        _mm_storeu_si128((__m128i *)(llr + i), sse_ldpc_unpack16(u, packed + i/8*bits));
+    for (; i < len; i++)
+        llr[i] = sse_ldpc_packed_value(packed, bits, i);
+}
+
+/* Expand packed LLRs of 128 codewords and interleave them into the SIMD layout, 16 codewords at a time */
+static void sse_ldpc_interleave_packed(ldpc_t *h, unsigned char *llr, int bits, ldpc_llr_t *llr_interl) {
+    ldpc_llr16_t *llr16_interl = (ldpc_llr16_t *)llr_interl;
+    size_t stride = ((size_t)h->in_len*bits + 7)/8;
+    char *rows = h->shared->rows;
+    sse_ldpc_unpack_t u;
+
+    sse_ldpc_unpack_setup(&u, bits);
+    for (int n = 0; n < LDPC_CODEWORD_BLOCKS; n++) {
+        for (int k = 0; k < 16; k++)
+            sse_ldpc_unpack(&u, llr + (16*n + k)*stride, stride, bits, h->in_len, rows + k*h->in_len);
+
+        if (h->precision == LDPC_PRECISION_16) {
+            for (int i = 0; i < h->N; i++)
+                for (int k = 0; k < 16; k++)
+                    llr16_interl[i*LDPC_CODEWORD_BLOCKS_16 + 2*n + k/8].b[k%8] = sse_ldpc_input(h, rows + k*h->in_len, i);
+        } else {
+            for (int i = 0; i < h->N; i++)
+                for (int k = 0; k < 16; k++)
+                    llr_interl[i*LDPC_CODEWORD_BLOCKS + n].b[k] = sse_ldpc_input(h, rows + k*h->in_len, i);
+        }
+    }
+}
 
+/* Fill in the status of each codeword from the final parity check.
+ * Returns the number of valid codewords.
+ */
+static int sse_ldpc_update_status(ldpc_t *h) {
+    unsigned char unsat[LDPC_CODEWORD_BLOCKS*16] __attribute__ ((aligned (16)));
+    int num_valid = 0;
+
+    for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS; cw_block++) {
+        __m128i acc = _mm_setzero_si128();
+        for (int t = 0; t < h->num_threads; t++)
+            acc = _mm_or_si128(acc, _mm_load_si128((__m128i *)&h->unsat[t*LDPC_CODEWORD_BLOCKS + cw_block].v));
+        _mm_store_si128((__m128i *)&unsat[cw_block*16], acc);
+    }
 
-    llr_interl = (ldpc_llr_t *) _mm_malloc(LDPC_CODEWORD_BLOCKS*h->N*sizeof(ldpc_llr_t), 64); //64-byte to align with cache lines
+    /* Results are at the codeword's position in the batch, which bit-flipping may have changed */
+    for (int cw = 0; cw < LDPC_CODEWORD_BLOCKS*16; cw++) {
+        int pos = h->lane_pos[cw];
+
+        if (pos >= h->ms_lanes) {
+            /* Solved by bit-flipping */
+            h->status[cw].valid = 1;
+            h->status[cw].iterations = 0;
+        } else {
+            h->status[cw].valid = !unsat[pos];
+            if (h->status[cw].valid && h->conv_iter[pos] != LDPC_NOT_CONVERGED)
+                h->status[cw].iterations = h->conv_iter[pos];
+            else
+                h->status[cw].iterations = h->iterations;
+        }
+        h->status[cw].cut_off = h->cut_off && !h->status[cw].valid;
+        num_valid += h->status[cw].valid;
+    }
 
-    for(int i = 0; i < h->N;i++) {
-        for (int n=0;n<LDPC_CODEWORD_BLOCKS;n++)  {
-            for (int k=0;k<16;k++) {
-                llr_interl[i*LDPC_CODEWORD_BLOCKS+n].b[k] = llr[(16*n + k)*h->N + i];
+    return num_valid;
+}
+
+/* Hard decisions and unreliable bits of the channel LLRs of bit n, packed one bit per codeword.
+ * Level l flags the LLRs with a magnitude below bf_threshold*(l+1)/2.
+ */
+static void sse_ldpc_bf_pack(ldpc_t *h, ldpc_llr_t *llr_interl, int n) {
+    unsigned short hard[8] __attribute__ ((aligned (16)));
+    unsigned short weak[LDPC_BF_LEVELS][8] __attribute__ ((aligned (16)));
+    __m128i a, b, thr;
+
+    for (int blk = 0; blk < LDPC_CODEWORD_BLOCKS; blk++) {
+        if (h->precision == LDPC_PRECISION_16) {
+            ldpc_llr16_t *llr = (ldpc_llr16_t *)llr_interl + n*LDPC_CODEWORD_BLOCKS_16;
+
+            a = _mm_load_si128((__m128i *)&llr[2*blk].v);
+            b = _mm_load_si128((__m128i *)&llr[2*blk + 1].v);
+            hard[blk] = _mm_movemask_epi8(_mm_packs_epi16(a, b));
+            a = _mm_abs_epi16(a);
+            b = _mm_abs_epi16(b);
+            for (int l = 0; l < LDPC_BF_LEVELS; l++) {
+                thr = _mm_set1_epi16(h->bf_threshold*(l + 1)/2);
+                weak[l][blk] = _mm_movemask_epi8(_mm_packs_epi16(_mm_cmplt_epi16(a, thr), _mm_cmplt_epi16(b, thr)));
+            }
+        } else {
+            a = _mm_load_si128((__m128i *)&llr_interl[n*LDPC_CODEWORD_BLOCKS + blk].v);
+            hard[blk] = _mm_movemask_epi8(a);
+            a = _mm_abs_epi8(a);
+            /* Unsigned compare, so that |-128| counts as reliable */
+            for (int l = 0; l < LDPC_BF_LEVELS; l++) {
+                thr = _mm_set1_epi8(IMIN(h->bf_threshold*(l + 1)/2, 128));
+                weak[l][blk] = ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(a, thr), a));
             }
         }
     }
 
+    h->bf_hard[n] = _mm_load_si128((__m128i *)hard);
+    for (int l = 0; l < LDPC_BF_LEVELS; l++)
+        h->bf_weak[n*LDPC_BF_LEVELS + l] = _mm_load_si128((__m128i *)weak[l]);
+}
+
+/* Expand packed hard decisions of one bit to the ldpc_bit_t layout */
+static void sse_ldpc_bf_unpack(__m128i hard, ldpc_bit_t *bitval) {
+    const __m128i bits = _mm_set1_epi64x(0x8040201008040201LL);
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i spread = _mm_setr_epi8(0,0,0,0,0,0,0,0, 1,1,1,1,1,1,1,1);
+    __m128i v;
+
+    for (int blk = 0; blk < LDPC_CODEWORD_BLOCKS; blk++) {
+        v = _mm_and_si128(_mm_shuffle_epi8(hard, spread), bits);
+        _mm_store_si128((__m128i *)&bitval[blk].v, _mm_and_si128(_mm_cmpeq_epi8(v, bits), one));
+        spread = _mm_add_epi8(spread, _mm_set1_epi8(2));
+    }
+}
+
+/* Lanes of the bit-sliced counters cnt (bits wide) that are at least c */
+static inline __m128i sse_ldpc_bf_ge(const __m128i *cnt, int bits, int c) {
+    __m128i gt = _mm_setzero_si128();
+    __m128i eq = _mm_set1_epi8(-1);
+
+    if (c >= (1 << bits))
+        return gt;
+
+    for (int b = bits - 1; b >= 0; b--) {
+        if ((c >> b) & 1) {
+            eq = _mm_and_si128(eq, cnt[b]);
+        } else {
+            gt = _mm_or_si128(gt, _mm_and_si128(eq, cnt[b]));
+            eq = _mm_andnot_si128(cnt[b], eq);
+        }
+    }
+
+    return _mm_or_si128(gt, eq);
+}
+
+/* Hard-decision bit-flipping of all 128 codewords at once, on bit-sliced hard decisions
+ * where each __m128i holds one bit (or check) of every codeword.
+ * In each iteration all bits are flipped in parallel that have all of their checks unsatisfied,
+ * or enough of them unsatisfied for the reliability of their channel LLR.
+ * The stage stops early when the number of unsatisfied checks no longer decreases.
+ * The hard decisions are written to bitval, and solved flags the valid codewords.
+ * Returns the number of valid codewords.
+ */
+static int sse_ldpc_bit_flip(ldpc_t *h, ldpc_llr_t *llr_interl, ldpc_bit_t *bitval, unsigned char *solved) {
+    __m128i unsat, synd, carry, tmp, flip;
+    __m128i cnt[16];
+    unsigned long long words[2] __attribute__ ((aligned (16)));
+    long num_unsat, prev_unsat = -1;
+    int index, deg, num_valid = 0;
+
+    for (int n = 0; n < h->N; n++)
+        sse_ldpc_bf_pack(h, llr_interl, n);
+
+    for (int iter = 0; ; iter++) {
+        unsat = _mm_setzero_si128();
+        num_unsat = 0;
+        for (int i = 0; i < h->M; i++) {
+            synd = _mm_setzero_si128();
+            index = h->row_idx[i];
+            do {
+                synd = _mm_xor_si128(synd, h->bf_hard[h->llr_map[index]]);
+                index = h->hb[index].i_next;
+            } while (index != h->row_idx[i]);
+            h->bf_synd[i] = synd;
+            unsat = _mm_or_si128(unsat, synd);
+
+            _mm_store_si128((__m128i *)words, synd);
+            num_unsat += __builtin_popcountll(words[0]) + __builtin_popcountll(words[1]);
+        }
+
+        if (iter == h->bf_max_iter || num_unsat == 0 || (prev_unsat >= 0 && num_unsat >= prev_unsat))
+            break;
+        prev_unsat = num_unsat;
+
+        for (int n = 0; n < h->N; n++) {
+            /* Count the unsatisfied checks of each codeword with bit-sliced adders */
+            for (int b = 0; b < h->bf_bits; b++)
+                cnt[b] = _mm_setzero_si128();
+            deg = 0;
+            index = h->col_idx[n];
+            do {
+                carry = h->bf_synd[h->edge_row[index]];
+                for (int b = 0; b < h->bf_bits; b++) {
+                    tmp = _mm_and_si128(cnt[b], carry);
+                    cnt[b] = _mm_xor_si128(cnt[b], carry);
+                    carry = tmp;
+                }
+                deg++;
+                index = h->hc[index].i_next;
+            } while (index != h->col_idx[n]);
+
+            /* The less reliable the channel LLR, the fewer unsatisfied checks it takes */
+            flip = sse_ldpc_bf_ge(cnt, h->bf_bits, deg);
+            for (int l = 0; l < LDPC_BF_LEVELS; l++)
+                flip = _mm_or_si128(flip, _mm_and_si128(sse_ldpc_bf_ge(cnt, h->bf_bits, IMIN((deg + 1)/2 + l, deg)),
+                                                        h->bf_weak[n*LDPC_BF_LEVELS + l]));
+            h->bf_hard[n] = _mm_xor_si128(h->bf_hard[n], flip);
+        }
+    }
+
+    for (int n = 0; n < h->N; n++)
+        sse_ldpc_bf_unpack(h->bf_hard[n], &bitval[n*LDPC_CODEWORD_BLOCKS]);
+
+    _mm_store_si128((__m128i *)words, unsat);
+    for (int cw = 0; cw < LDPC_CODEWORD_BLOCKS*16; cw++) {
+        solved[cw] = !((words[cw/64] >> (cw%64)) & 1);
+        num_valid += solved[cw];
+    }
+
+    return num_valid;
+}
+
+/* Move the codewords left unsolved by bit-flipping to the first codeword blocks of the batch,
+ * so min-sum only has to run on as many blocks as they need. The channel LLRs and hard
+ * decisions of each bit are permuted in place, and h->lane_pos gets the new position of
+ * each codeword. Solved codewords sharing the last min-sum block with unsolved ones get
+ * zero LLRs, which satisfy all checks at once, and their decisions are saved in
+ * h->bf_saved, see sse_ldpc_bf_restore. Sets h->ms_lanes and returns the number of
+ * blocks left for min-sum.
+ */
+static int sse_ldpc_bf_compact(ldpc_t *h, const unsigned char *solved, ldpc_llr_t *llr_interl, ldpc_bit_t *bitval) {
+    unsigned char src[LDPC_CODEWORD_BLOCKS*16];
+    int num_failed = 0, num = 0, blocks;
+
+    for (int cw = 0; cw < LDPC_CODEWORD_BLOCKS*16; cw++)
+        if (!solved[cw])
+            src[num_failed++] = cw;
+    blocks = (num_failed + 15)/16;
+    h->ms_lanes = num_failed;
+    if (num_failed == 0 || num_failed == LDPC_CODEWORD_BLOCKS*16)
+        return blocks;
+
+    num = num_failed;
+    for (int cw = 0; cw < LDPC_CODEWORD_BLOCKS*16; cw++)
+        if (solved[cw])
+            src[num++] = cw;
+    for (int pos = 0; pos < LDPC_CODEWORD_BLOCKS*16; pos++)
+        h->lane_pos[src[pos]] = pos;
+
+    /* In both layouts, the values of one bit are stored in codeword order */
+    for (int n = 0; n < h->N; n++) {
+        unsigned char *row = bitval[n*LDPC_CODEWORD_BLOCKS].b;
+        unsigned char tmp[LDPC_CODEWORD_BLOCKS*16];
+
+        memcpy(tmp, row, sizeof(tmp));
+        for (int pos = 0; pos < LDPC_CODEWORD_BLOCKS*16; pos++)
+            row[pos] = tmp[src[pos]];
+
+        if (h->precision == LDPC_PRECISION_16) {
+            short *llr = ((ldpc_llr16_t *)llr_interl)[n*LDPC_CODEWORD_BLOCKS_16].b;
+            short tmp16[LDPC_CODEWORD_BLOCKS*16];
+
+            memcpy(tmp16, llr, sizeof(tmp16));
+            for (int pos = 0; pos < LDPC_CODEWORD_BLOCKS*16; pos++)
+                llr[pos] = pos < num_failed || pos >= blocks*16 ? tmp16[src[pos]] : 0;
+        } else {
+            char *llr = llr_interl[n*LDPC_CODEWORD_BLOCKS].b;
+
+            memcpy(tmp, llr, sizeof(tmp));
+            for (int pos = 0; pos < LDPC_CODEWORD_BLOCKS*16; pos++)
+                llr[pos] = pos < num_failed || pos >= blocks*16 ? tmp[src[pos]] : 0;
+        }
+
+        h->bf_saved[n] = bitval[n*LDPC_CODEWORD_BLOCKS + blocks - 1];
+    }
+
+    return blocks;
+}
+
+/* Put back the bit-flipping decisions of the solved codewords in the last min-sum block */
+static void sse_ldpc_bf_restore(ldpc_t *h, ldpc_bit_t *bitval) {
+    const int blk = h->ms_lanes/16;
+    __m128i ms, *hard;
+
+    if (h->ms_lanes % 16 == 0)
+        return;
+
+    /* Lanes below ms_lanes % 16 were decoded by min-sum */
+    ms = _mm_cmpgt_epi8(_mm_set1_epi8(h->ms_lanes % 16), _mm_setr_epi8(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15));
+    for (int n = 0; n < h->N; n++) {
+        hard = (__m128i *)&bitval[n*LDPC_CODEWORD_BLOCKS + blk].v;
+        _mm_store_si128(hard, VEC_BLEND(_mm_load_si128((__m128i *)&h->bf_saved[n].v), _mm_load_si128(hard), ms));
+    }
+}
+
+int ldpc_decoder_status_sse(ldpc_t *h, ldpc_status_t *status) {
+    int num_valid = 0;
+
+    for (int cw = 0; cw < LDPC_CODEWORD_BLOCKS*16; cw++) {
+        status[cw] = h->status[cw];
+        num_valid += status[cw].valid;
+    }
+
+    return num_valid;
+}
+
+/* Set the deadline of the batch at the start of a decode call */
+static void sse_ldpc_start_deadline(ldpc_t *h) {
+    const struct timespec *deadline = NULL;
+
+    if (h->has_next_deadline) {
+        h->deadline = h->next_deadline;
+        h->has_next_deadline = 0;
+        deadline = &h->deadline;
+    } else if (h->deadline_us) {
+        clock_gettime(CLOCK_MONOTONIC, &h->deadline);
+        h->deadline.tv_sec += h->deadline_us / 1000000;
+        h->deadline.tv_nsec += (h->deadline_us % 1000000) * 1000;
+        if (h->deadline.tv_nsec >= 1000000000) {
+            h->deadline.tv_sec++;
+            h->deadline.tv_nsec -= 1000000000;
+        }
+        deadline = &h->deadline;
+    }
+
+    /* Only the first check node thread watches the clock */
+    h->cn_args[0].deadline = deadline;
+}
+
+/* Run the message passing iterations set up in the thread arguments, on the workers or
+ * on the calling thread. Without workers there is one thread of each kind, and its
+ * updates run in the order the barriers impose on the worker threads.
+ */
+static void sse_ldpc_iterate(ldpc_t *h) {
+    ldpc_pool_job_t jobs[h->num_threads*2];
+    struct bn_update_args *bn = &h->bn_args[0];
+    struct cn_update_args *cn = &h->cn_args[0];
+
+    if (h->shared->pool) {
+        for (int t=0; t<h->num_threads; t++) {
+            jobs[t].fn = h->bn_update;
+            jobs[t].arg = &h->bn_args[t];
+            jobs[h->num_threads+t].fn = h->cn_update;
+            jobs[h->num_threads+t].arg = &h->cn_args[t];
+        }
+        ldpc_pool_run(h->shared->pool, jobs, h->num_threads*2);
+        return;
+    }
+
+    for (unsigned short iter = 1; iter <= cn->max_iter; iter++) {
+        h->bn_pass(bn);
+        h->cn_pass(cn);
+        sse_ldpc_check_deadline(cn);
+        if (cn->conv_iter)
+            sse_ldpc_record_convergence(cn, iter);
+        if (h->stop)
+            break;
+        if (cn->bitval && sse_ldpc_all_satisfied(h->unsat, 1))
+            break;
+    }
+}
 
-    bitval_interl = (ldpc_bit_t *)_mm_malloc(LDPC_CODEWORD_BLOCKS*h->N*sizeof(ldpc_bit_t), 64);
+/* Mark the codewords whose hard decisions passed the parity check of the last iteration
+ * in h->keep. One more bit node update, on the check node messages of that iteration,
+ * could still change their decisions, so the final update leaves them as they were
+ * checked. Returns 1 if all codewords passed, and the final update can be skipped.
+ */
+static int sse_ldpc_keep_checked(ldpc_t *h) {
+    __m128i acc, any = _mm_setzero_si128();
+
+    for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS; cw_block++) {
+        acc = _mm_setzero_si128();
+        for (int t = 0; t < h->num_threads; t++)
+            acc = _mm_or_si128(acc, _mm_load_si128((__m128i *)&h->unsat[t*LDPC_CODEWORD_BLOCKS + cw_block].v));
+        _mm_store_si128((__m128i *)&h->keep[cw_block].v, _mm_cmpeq_epi8(acc, _mm_setzero_si128()));
+        any = _mm_or_si128(any, acc);
+    }
+
+    return _mm_testz_si128(any, any);
+}
+
+/* Final bit node update with hard decisions and parity check */
+static void sse_ldpc_hard_decision(ldpc_t *h) {
+    ldpc_pool_job_t jobs[h->num_threads];
+
+    if (!h->shared->pool) {
+        h->bn_update_bitval(&h->bn_bv_args[0]);
+        return;
+    }
+    for (int t=0; t<h->num_threads; t++) {
+        jobs[t].fn = h->bn_update_bitval;
+        jobs[t].arg = &h->bn_bv_args[t];
+    }
+    ldpc_pool_run(h->shared->pool, jobs, h->num_threads);
+}
+
+/* Decode a batch of LLRs already interleaved into the SIMD layout.
+ * Hard decisions are written to bitval and soft output to llr_out, either may be NULL.
+ */
+static int sse_ldpc_decode_interleaved(ldpc_t *h, ldpc_llr_t *llr_interl, unsigned char *bitval, char *llr_out) {
+    ldpc_bit_t *bitval_interl = h->shared->bitval_interl;
+    ldpc_llr_t *soft_interl = llr_out ? h->shared->soft_interl : NULL;
 
     /* Set up threads */
     for(int i=0; i<h->num_threads; i++) {
         h->bn_args[i].llr = llr_interl;
+        h->bn_args[i].bitval = h->early_termination ? bitval_interl : NULL;
+        h->cn_args[i].bitval = h->early_termination ? bitval_interl : NULL;
+        h->bn_args[i].sign_parity = h->sign_parity;
+        h->cn_args[i].sign_parity = h->sign_parity;
 
         h->bn_bv_args[i].llr = llr_interl;
         h->bn_bv_args[i].bitval = bitval_interl;
+        h->bn_bv_args[i].soft = soft_interl;
 
         h->cs_args[i].bitval = bitval_interl;
+    }
+    unsigned char solved[LDPC_CODEWORD_BLOCKS*16];
+    unsigned char *active = NULL;
+    unsigned long long tsc, tsc_prev;
+
+    tsc_prev = __rdtsc();
+
+    for (int cw = 0; cw < LDPC_CODEWORD_BLOCKS*16; cw++)
+        h->lane_pos[cw] = cw;
+    h->ms_blocks = LDPC_CODEWORD_BLOCKS;
+    h->ms_lanes = LDPC_CODEWORD_BLOCKS*16;
+
+    /* Codewords corrected by bit-flipping are left out of min-sum */
+    if (h->bf_max_iter && !llr_out) {
+        h->stats.bf_frames += sse_ldpc_bit_flip(h, llr_interl, bitval_interl, solved);
+        h->ms_blocks = sse_ldpc_bf_compact(h, solved, llr_interl, bitval_interl);
+        for (int i = 0; i < LDPC_CODEWORD_BLOCKS; i++)
+            h->active[i] = i < h->ms_blocks;
+        active = h->active;
+
+        tsc = __rdtsc();
+        h->stats.bf_cycles += tsc - tsc_prev;
+        tsc_prev = tsc;
+    }
+    for (int i=0; i<h->num_threads; i++) {
+        h->bn_args[i].active = active;
+        h->bn_bv_args[i].active = active;
+        h->cn_args[i].active = active;
+    }
 
+    for (int cw = 0; cw < LDPC_CODEWORD_BLOCKS*16; cw++)
+        h->conv_iter[cw] = LDPC_NOT_CONVERGED;
+    h->iterations = 0;
 
+    /* Iterations allowed for this batch */
+    unsigned short max_iter = h->max_iter;
+    if (h->iter_budget) {
+        h->iter_credit = IMIN(h->iter_credit + h->iter_budget, h->iter_budget_max);
+        max_iter = IMIN(max_iter, h->iter_credit);
+    }
+    h->stop = 0;
+    for (int i=0; i<h->num_threads; i++) {
+        h->bn_args[i].max_iter = max_iter;
+        h->cn_args[i].max_iter = max_iter;
+    }
 
+    if (h->ms_blocks == 0) {
+        /* Nothing left for min-sum */
+        memset(h->unsat, 0, h->num_threads*LDPC_CODEWORD_BLOCKS*sizeof(ldpc_bit_t));
+        for (int cw = 0; cw < LDPC_CODEWORD_BLOCKS*16; cw++)
+            h->conv_iter[cw] = 0;
+        h->stats.bf_batches++;
+    } else {
+        ldpc_init_messages_sse(h);
+
+        /* Bit node update and check node update
+               Note: With early termination, the threads stop as soon as
+               all codewords satisfy the parity checks.
+            */
+        sse_ldpc_iterate(h);
+
+        tsc = __rdtsc();
+        h->stats.iteration_cycles += tsc - tsc_prev;
+        tsc_prev = tsc;
+
+        /* Without soft output, codewords keep the hard decisions that were checked. The
+         * soft output is made in the final update, and so are the decisions checked with it.
+         */
+        ldpc_bit_t *keep = NULL;
+        int all_kept = 0;
+        if (h->early_termination && !h->sign_parity && !llr_out && h->iterations) {
+            all_kept = sse_ldpc_keep_checked(h);
+            keep = h->keep;
+        }
+        if (!all_kept) {
+            for (int i=0; i<h->num_threads; i++)
+                h->bn_bv_args[i].keep = keep;
+            sse_ldpc_hard_decision(h);
+        }
+        if (active)
+            sse_ldpc_bf_restore(h, bitval_interl);
     }
-    pthread_t thread_handles[h->num_threads*2];
-    int rc;
-    void *thread_status;
 
-    BENCHMARK_NOW(1, "SSE LDPC intitialization time: ");
+    if (h->iter_budget && h->ms_blocks)
+        h->iter_credit -= h->iterations;
+    h->cut_off = h->stop || (max_iter < h->max_iter && h->iterations == max_iter);
 
-    START_CLOCK(1);
-    ldpc_init_messages_sse(h);
+    int num_valid = sse_ldpc_update_status(h);
 
-    int unsat = 1;
+    tsc = __rdtsc();
+    h->stats.hard_decision_cycles += tsc - tsc_prev;
+    tsc_prev = tsc;
 
-    /* Bit node update
-           Note: No early termination
-        */
-    for (int t=0; t<h->num_threads; t++) {
-        rc = pthread_create(&thread_handles[t], NULL, sse_ldpc_ms_bn_update, (void *) &h->bn_args[t]);
-        if (rc) {
-            fprintf(stderr, "ERROR; return code from pthread_create() is %d\n", rc);
-            exit(-1);
+    if (bitval) {
+        for(int n=0;n<h->K;n++) {
+            const unsigned char *row = bitval_interl[(h->bit_pos ? h->bit_pos[n] : n)*LDPC_CODEWORD_BLOCKS].b;
+            for (int cw=0;cw<LDPC_CODEWORD_BLOCKS*16;cw++) {
+                bitval[cw*h->K + n] = row[h->lane_pos[cw]];
+            }
         }
     }
 
-    /* Check node update */
-    for (int t=0; t<h->num_threads; t++) {
-        rc = pthread_create(&thread_handles[h->num_threads+t], NULL, sse_ldpc_ms_cn_update, (void *) &h->cn_args[t]);
-        if (rc) {
-            fprintf(stderr, "ERROR; return code from pthread_create() is %d\n", rc);
-            exit(-1);
+    if (llr_out) {
+        for(int n=0;n<h->soft_len;n++) {
+            int pos = h->bit_pos ? h->bit_pos[n] : n;
+            for(int i=0;i<LDPC_CODEWORD_BLOCKS;i++) {
+                for (int k=0;k<16;k++) {
+                    llr_out[(i*16+k)*h->soft_len + n] = soft_interl[pos*LDPC_CODEWORD_BLOCKS + i].b[k];
+                }
+            }
         }
     }
 
-    // Join all the threads in order to ensure they're all finished
-    for (int t=0; t<h->num_threads*2; t++) {
-        rc = pthread_join(thread_handles[t], &thread_status);
-        if (rc) {
-            printf("ERROR; return code from pthread_join() is %d\n", rc);
-            exit(-1);
-        }
+    h->stats.copy_back_cycles += __rdtsc() - tsc_prev;
+    h->stats.batches++;
+    h->stats.iterations += h->iterations;
+    h->stats.frames += LDPC_CODEWORD_BLOCKS*16;
+    h->stats.failed_frames += LDPC_CODEWORD_BLOCKS*16 - num_valid;
+    if (h->cut_off)
+        h->stats.cut_off_frames += LDPC_CODEWORD_BLOCKS*16 - num_valid;
+
+    return num_valid;
+
+}
+
+int ldpc_decode_sse(ldpc_t *h, char *llr, unsigned char *bitval) {
+    ldpc_llr_t *llr_interl;
+
+    unsigned long long tsc = __rdtsc();
+
+    sse_ldpc_start_deadline(h);
+    llr_interl = h->shared->llr_interl;
+    sse_ldpc_interleave(h, llr, llr_interl);
+    h->stats.interleave_cycles += __rdtsc() - tsc;
+
+    return sse_ldpc_decode_interleaved(h, llr_interl, bitval, NULL);
+}
+
+int ldpc_decode_soft_sse(ldpc_t *h, char *llr, char *llr_out) {
+    ldpc_llr_t *llr_interl;
+
+    unsigned long long tsc = __rdtsc();
+
+    sse_ldpc_start_deadline(h);
+    llr_interl = h->shared->llr_interl;
+    sse_ldpc_interleave(h, llr, llr_interl);
+    h->stats.interleave_cycles += __rdtsc() - tsc;
+
+    return sse_ldpc_decode_interleaved(h, llr_interl, NULL, llr_out);
+}
+
+int ldpc_decode_float_sse(ldpc_t *h, float *llr, float *frame_scale, unsigned char *bitval) {
+    ldpc_llr_t *llr_interl;
+
+    unsigned long long tsc = __rdtsc();
+
+    sse_ldpc_start_deadline(h);
+    llr_interl = h->shared->llr_interl;
+    sse_ldpc_interleave_float(h, llr, frame_scale, llr_interl);
+    h->stats.interleave_cycles += __rdtsc() - tsc;
+
+    return sse_ldpc_decode_interleaved(h, llr_interl, bitval, NULL);
+}
+
+int ldpc_decode_packed_sse(ldpc_t *h, unsigned char *llr, int bits, unsigned char *bitval) {
+    ldpc_llr_t *llr_interl;
+    unsigned long long tsc;
+
+    if (bits < LDPC_PACKED_MIN_BITS || bits > 8) {
+        fprintf(stderr, "Unsupported packed LLR width %d\n", bits);
+        return -1;
     }
 
-    if(unsat != 0) {
-        /* Bit node update with hard decision */
-        for (int t=0; t<h->num_threads; t++) {
-            rc = pthread_create(&thread_handles[t], NULL, sse_ldpc_ms_bn_update_bitval, (void *) &h->bn_bv_args[t]);
-            if (rc) {
-                fprintf(stderr, "ERROR; return code from pthread_create() is %d\n", rc);
-                exit(-1);
-            }
-        }
-        for (int t=0; t<h->num_threads; t++) {
-            rc = pthread_join(thread_handles[t], &thread_status);
-            if (rc) {
-                printf("ERROR; return code from pthread_join() is %d\n", rc);
-                exit(-1);
-            }
+    tsc = __rdtsc();
+    sse_ldpc_start_deadline(h);
+    llr_interl = h->shared->llr_interl;
+    sse_ldpc_interleave_packed(h, llr, bits, llr_interl);
+    h->stats.interleave_cycles += __rdtsc() - tsc;
+
+    return sse_ldpc_decode_interleaved(h, llr_interl, bitval, NULL);
+}
+
+/* Load the next frames of a stream into codeword block b and clear its messages.
+ * Lanes left without a frame get zero LLRs, which satisfy all parity checks at once.
+ * Returns the number of frames loaded.
+ */
+static int sse_ldpc_stream_load(ldpc_t *h, int b, char *frames, long *frame_id, long *num_frames,
+                                int (*next)(void *ctx, char *llr), void *ctx, unsigned char *ended) {
+    ldpc_llr_t *llr_interl = h->shared->llr_interl;
+    const __m128i zero = _mm_setzero_si128();
+    int n = 0;
+
+    while (n < 16 && !*ended) {
+        if (next(ctx, frames + n*h->in_len)) {
+            frame_id[n++] = (*num_frames)++;
+        } else {
+            *ended = 1;
         }
     }
+    if (n == 0)
+        return 0;
 
+    for (int i = 0; i < h->N; i++)
+        for (int k = 0; k < 16; k++)
+            llr_interl[i*LDPC_CODEWORD_BLOCKS + b].b[k] = k < n ? sse_ldpc_input(h, frames + k*h->in_len, i) : 0;
+    for (int e = 0; e < h->num_edges; e++)
+        _mm_store_si128((__m128i *)&h->edge_msg[e].message[b].v, zero);
 
-    BENCHMARK_NOW(1, "SSE LDPC decode time: ");
+    return n;
+}
 
-    START_CLOCK(1)
+long ldpc_decode_stream_sse(ldpc_t *h, int (*next)(void *ctx, char *llr),
+                            void (*done)(void *ctx, long frame, const unsigned char *bitval, const ldpc_status_t *status), void *ctx) {
+    ldpc_bit_t *bitval_interl = h->shared->bitval_interl;
+    long frame_id[LDPC_CODEWORD_BLOCKS*16];
+    unsigned short conv_iter[LDPC_CODEWORD_BLOCKS*16];
+    int lanes[LDPC_CODEWORD_BLOCKS]; /* Frames in each block */
+    unsigned short block_iter[LDPC_CODEWORD_BLOCKS]; /* Iterations of the frames in each block */
+    long num_frames = 0, num_done = 0;
+    unsigned char ended = 0;
+    ldpc_status_t status;
+    ldpc_bit_t unsat;
+    unsigned long long tsc;
+    char *frames;
+    unsigned char *bits;
+
+    if (h->precision != LDPC_PRECISION_8) {
+        fprintf(stderr, "Continuous decoding requires 8-bit messages\n");
+        return -1;
+    }
+    frames = (char *)malloc(16*h->in_len);
+    bits = (unsigned char *)malloc(h->K);
+
+    /* One iteration at a time, with the blocks retired and refilled in between */
+    for (int t = 0; t < h->num_threads; t++) {
+        h->bn_args[t].llr = h->shared->llr_interl;
+        h->bn_args[t].bitval = bitval_interl;
+        h->bn_args[t].sign_parity = 0; /* The hard decisions are the output */
+        h->bn_args[t].max_iter = 1;
+        h->bn_args[t].active = h->active;
+        h->cn_args[t].bitval = bitval_interl;
+        h->cn_args[t].sign_parity = 0;
+        h->cn_args[t].max_iter = 1;
+        h->cn_args[t].active = h->active;
+        h->cn_args[t].deadline = NULL;
+    }
+    h->stop = 0;
+
+    tsc = __rdtsc();
+    for (int b = 0; b < LDPC_CODEWORD_BLOCKS; b++) {
+        lanes[b] = sse_ldpc_stream_load(h, b, frames, &frame_id[b*16], &num_frames, next, ctx, &ended);
+        block_iter[b] = 0;
+        for (int k = 0; k < 16; k++)
+            conv_iter[b*16 + k] = LDPC_NOT_CONVERGED;
+    }
+    h->stats.interleave_cycles += __rdtsc() - tsc;
+
+    for (;;) {
+        int num_active = 0;
 
-    for(int n=0;n<h->K;n++) {
-        for(int i=0;i<LDPC_CODEWORD_BLOCKS;i++) {
-            for (int k=0;k<16;k++) {
-                bitval[(i*16+k)*h->K + n] = (unsigned char) bitval_interl[n*LDPC_CODEWORD_BLOCKS + i].b[k];
+        for (int b = 0; b < LDPC_CODEWORD_BLOCKS; b++) {
+            h->active[b] = lanes[b] > 0;
+            num_active += h->active[b];
+        }
+        if (!num_active)
+            break;
+
+        tsc = __rdtsc();
+        sse_ldpc_iterate(h);
+        h->stats.iteration_cycles += __rdtsc() - tsc;
+        h->stats.iterations++;
+
+        tsc = __rdtsc();
+        for (int b = 0; b < LDPC_CODEWORD_BLOCKS; b++) {
+            __m128i acc = _mm_setzero_si128();
+
+            if (!lanes[b])
+                continue;
+            for (int t = 0; t < h->num_threads; t++)
+                acc = _mm_or_si128(acc, _mm_load_si128((__m128i *)&h->unsat[t*LDPC_CODEWORD_BLOCKS + b].v));
+            _mm_store_si128((__m128i *)&unsat.v, acc);
+            block_iter[b]++;
+
+            /* The checked hard decisions were made before this iteration's check node update */
+            for (int k = 0; k < 16; k++) {
+                if (unsat.b[k])
+                    conv_iter[b*16 + k] = LDPC_NOT_CONVERGED;
+                else if (conv_iter[b*16 + k] == LDPC_NOT_CONVERGED)
+                    conv_iter[b*16 + k] = block_iter[b] - 1;
             }
+            /* The hard decisions after max_iter check node updates are checked in the next round */
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF && block_iter[b] <= h->max_iter)
+                continue;
+
+            /* Retire the block */
+            for (int k = 0; k < lanes[b]; k++) {
+                for (int n = 0; n < h->K; n++)
+                    bits[n] = bitval_interl[(h->bit_pos ? h->bit_pos[n] : n)*LDPC_CODEWORD_BLOCKS + b].b[k];
+                status.valid = !unsat.b[k];
+                status.iterations = status.valid ? conv_iter[b*16 + k] : block_iter[b] - 1;
+                status.cut_off = 0;
+                done(ctx, frame_id[b*16 + k], bits, &status);
+
+                h->stats.frames++;
+                h->stats.failed_frames += !status.valid;
+                num_done++;
+            }
+
+            lanes[b] = sse_ldpc_stream_load(h, b, frames, &frame_id[b*16], &num_frames, next, ctx, &ended);
+            block_iter[b] = 0;
+            for (int k = 0; k < 16; k++)
+                conv_iter[b*16 + k] = LDPC_NOT_CONVERGED;
         }
+        h->stats.copy_back_cycles += __rdtsc() - tsc;
     }
 
-    BENCHMARK_NOW(1, "SSE LDPC copy back time: ");
+    free(frames);
+    free(bits);
+
+    return num_done;
+}
+
+void ldpc_decoder_stats_sse(ldpc_t *h, ldpc_stats_t *stats) {
+    *stats = h->stats;
+    for (int i = 0; i < h->num_threads; i++) {
+        for (int d = 0; d < LDPC_STATS_MAX_DEGREE; d++) {
+            stats->cn_degree_cycles[d] += h->cn_degree_cycles[i][d];
+            stats->bn_degree_cycles[d] += h->bn_degree_cycles[i][d];
+        }
+    }
+}
 
-    //Free memory
-    _mm_free(llr_interl);
-    _mm_free(bitval_interl);
+void ldpc_decoder_stats_reset_sse(ldpc_t *h) {
+    memset(&h->stats, 0, sizeof(ldpc_stats_t));
+    h->stats.num_threads = h->num_threads;
+    memset(h->cn_degree_cycles, 0, h->num_threads*sizeof(*h->cn_degree_cycles));
+    memset(h->bn_degree_cycles, 0, h->num_threads*sizeof(*h->bn_degree_cycles));
+}
 
-    return 1;
+void ldpc_decoder_set_deadline_sse(ldpc_t *h, const struct timespec *deadline) {
+    h->has_next_deadline = deadline != NULL;
+    if (deadline)
+        h->next_deadline = *deadline;
+}
 
+int ldpc_decoder_num_threads_sse(ldpc_t *h) {
+    return h->shared->pool ? h->num_threads : 0;
 }
 
 size_t ldpc_decoder_input_size_sse(ldpc_t *h) {
-    return h->N*LDPC_CODEWORD_BLOCKS*16*sizeof(char);
+    return h->in_len*LDPC_CODEWORD_BLOCKS*16*sizeof(char);
+}
+
+size_t ldpc_decoder_packed_input_size_sse(ldpc_t *h, int bits) {
+    return ((size_t)h->in_len*bits + 7)/8*LDPC_CODEWORD_BLOCKS*16;
 }
 
 size_t ldpc_decoder_output_size_sse(ldpc_t *h) {
     return h->K*LDPC_CODEWORD_BLOCKS*16*sizeof(unsigned char);
 }
 
+size_t ldpc_decoder_soft_output_size_sse(ldpc_t *h) {
+    return h->soft_len*LDPC_CODEWORD_BLOCKS*16*sizeof(char);
+}
+
+ldpc_engine_t *ldpc_engine_init_sse(unsigned short num_threads) {
+    ldpc_engine_t *e = (ldpc_engine_t *)calloc(1, sizeof(ldpc_engine_t));
+
+    num_threads = CLAMP(num_threads, 1, LDPC_MAX_NUM_THREADS);
+    if (sse_ldpc_shared_init(&e->shared, num_threads, 1)) {
+        free(e);
+        return NULL;
+    }
+    fprintf(stderr, "Using %d simultaneous threads\n", num_threads);
+
+    return e;
+}
+
+int ldpc_engine_add_code_sse(ldpc_engine_t *e, ldpc_param_t *param) {
+    ldpc_t *h = sse_ldpc_create(param, &e->shared);
+
+    if (!h)
+        return -1;
+    e->codes = (ldpc_t **)realloc(e->codes, (e->num_codes + 1)*sizeof(ldpc_t *));
+    e->codes[e->num_codes] = h;
+
+    /* The scratch memory may have grown for the new code */
+    for (int i = 0; i < e->num_codes; i++)
+        sse_ldpc_attach_scratch(e->codes[i]);
+
+    return e->num_codes++;
+}
+
+ldpc_t *ldpc_engine_code_sse(ldpc_engine_t *e, int code) {
+    return code >= 0 && code < e->num_codes ? e->codes[code] : NULL;
+}
+
+int ldpc_engine_decode_sse(ldpc_engine_t *e, int code, char *llr_in, unsigned char *bitval) {
+    ldpc_t *h = ldpc_engine_code_sse(e, code);
+
+    return h ? ldpc_decode_sse(h, llr_in, bitval) : -1;
+}
+
+void ldpc_engine_destroy_sse(ldpc_engine_t *e) {
+    for (int i = 0; i < e->num_codes; i++)
+        ldpc_destroy_sse(e->codes[i]);
+    free(e->codes);
+    sse_ldpc_shared_destroy(&e->shared);
+    free(e);
+}
+
 /* Link architecture-dependent functions to function pointers defined in interface */
 int (*ldpc_decode)(ldpc_t *h, char *llr_in, unsigned char *bitval) = ldpc_decode_sse;
+int (*ldpc_decode_float)(ldpc_t *h, float *llr_in, float *frame_scale, unsigned char *bitval) = ldpc_decode_float_sse;
+int (*ldpc_decode_packed)(ldpc_t *h, unsigned char *llr_in, int bits, unsigned char *bitval) = ldpc_decode_packed_sse;
+int (*ldpc_decode_soft)(ldpc_t *h, char *llr_in, char *llr_out) = ldpc_decode_soft_sse;
 ldpc_t * (*ldpc_init)(ldpc_param_t *param) = ldpc_init_sse;
 void (*ldpc_destroy)(ldpc_t *h) = ldpc_destroy_sse;
 size_t (*ldpc_decoder_input_size)(ldpc_t *h) = ldpc_decoder_input_size_sse;
+size_t (*ldpc_decoder_packed_input_size)(ldpc_t *h, int bits) = ldpc_decoder_packed_input_size_sse;
 size_t (*ldpc_decoder_output_size)(ldpc_t *h) = ldpc_decoder_output_size_sse;
-
+size_t (*ldpc_decoder_soft_output_size)(ldpc_t *h) = ldpc_decoder_soft_output_size_sse;
+int (*ldpc_decoder_status)(ldpc_t *h, ldpc_status_t *status) = ldpc_decoder_status_sse;
+void (*ldpc_decoder_stats)(ldpc_t *h, ldpc_stats_t *stats) = ldpc_decoder_stats_sse;
+void (*ldpc_decoder_stats_reset)(ldpc_t *h) = ldpc_decoder_stats_reset_sse;
+void (*ldpc_decoder_set_deadline)(ldpc_t *h, const struct timespec *deadline) = ldpc_decoder_set_deadline_sse;
+int (*ldpc_decoder_num_threads)(ldpc_t *h) = ldpc_decoder_num_threads_sse;
+ldpc_engine_t *(*ldpc_engine_init)(unsigned short num_threads) = ldpc_engine_init_sse;
+int (*ldpc_engine_add_code)(ldpc_engine_t *e, ldpc_param_t *param) = ldpc_engine_add_code_sse;
+ldpc_t *(*ldpc_engine_code)(ldpc_engine_t *e, int code) = ldpc_engine_code_sse;
+int (*ldpc_engine_decode)(ldpc_engine_t *e, int code, char *llr_in, unsigned char *bitval) = ldpc_engine_decode_sse;
+void (*ldpc_engine_destroy)(ldpc_engine_t *e) = ldpc_engine_destroy_sse;
+long (*ldpc_decode_stream)(ldpc_t *h, int (*next)(void *ctx, char *llr), void (*done)(void *ctx, long frame, const unsigned char *bitval, const ldpc_status_t *status), void *ctx) = ldpc_decode_stream_sse;
@@ -37,11 +37,28 @@
 #else
 #include <tmmintrin.h>
 #endif
+#include <x86intrin.h>
 
 /* If we process 16 codewords in parallel using SIMD instructions,
     we need 8 blocks of codewords to decode 128 codewords. */
 #define LDPC_CODEWORD_BLOCKS 8
 
+/* With 16-bit messages, a SIMD vector holds 8 codewords,
+    so 16 blocks are needed for the same 128 codewords. */
+#define LDPC_CODEWORD_BLOCKS_16 16
+
+/* Largest supported check node and bit node degrees */
+#define LDPC_MAX_ROW_DEGREE 256
+#define LDPC_MAX_COL_DEGREE 256
+
+/* Nodes of degree up to this are updated by kernels unrolled for their degree */
+#define LDPC_MAX_UNROLL_DEGREE 32
+
+/* Applies X to each degree with an unrolled kernel */
+#define LDPC_UNROLLED_DEGREES(X) \
+    X(1)  X(2)  X(3)  X(4)  X(5)  X(6)  X(7)  X(8)  X(9)  X(10) X(11) X(12) X(13) X(14) X(15) X(16) \
+    X(17) X(18) X(19) X(20) X(21) X(22) X(23) X(24) X(25) X(26) X(27) X(28) X(29) X(30) X(31) X(32)
+
 //Number of threads to be spawned for each checknode/bitnode update in each iteration.
 #define LDPC_MAX_NUM_THREADS 128
 
@@ -58,6 +75,13 @@ typedef union {
     unsigned char b[16];
 } ldpc_bit_t;
 
+typedef short i16_vec __attribute__ ((__vector_size__ (16)));
+
+typedef union {
+    i16_vec v;
+    short b[8];
+} ldpc_llr16_t;
+
 typedef struct {
         int i_next;
 } ldpc_edge_t;
@@ -66,6 +90,39 @@ typedef struct {
     ldpc_llr_t message[LDPC_CODEWORD_BLOCKS];
 } ldpc_msg_t;
 
+/* Messages for LDPC_PRECISION_16. Block n holds codewords 8n..8n+7. */
+typedef struct {
+    ldpc_llr16_t message[LDPC_CODEWORD_BLOCKS_16];
+} ldpc_msg16_t;
+
+/* Reliability levels of the channel LLRs used by the bit-flipping stage */
+#define LDPC_BF_LEVELS 3
+
+/* Bits of H with a known value or no channel LLR, see shortened and punctured in ldpc_param_t */
+#define LDPC_BIT_SHORTENED 1
+#define LDPC_BIT_PUNCTURED 2
+
+/* Value of a codeword's convergence iteration while its parity checks are not satisfied */
+#define LDPC_NOT_CONVERGED 0xFFFF
+
+/* Consecutive nodes of equal degree. The nodes of each thread are split into
+ * such runs at initialization, so the kernels dispatch on the degree once per run.
+ */
+typedef struct {
+    int first_n;
+    int num_n;
+    int deg;
+} ldpc_degree_run_t;
+
+/* The thread arguments below are shared by the 8-bit and 16-bit kernels.
+ * The 16-bit kernels treat emsg and llr as ldpc_msg16_t and ldpc_llr16_t arrays.
+ * Hard decisions use the ldpc_bit_t layout regardless of precision.
+ *
+ * Parity check results are kept per thread as LDPC_CODEWORD_BLOCKS ldpc_bit_t masks
+ * (unsat), with a nonzero byte for each codeword having an unsatisfied check among
+ * the rows of that thread. unsat_all holds the masks of all num_threads threads.
+ */
+
 struct bn_update_args {
     int first_n;
     int num_n;
@@ -74,20 +131,51 @@ struct bn_update_args {
     int N;
     ldpc_msg_t *emsg;
     int *col_idx;
+    int *edges; /* Edges of each bit node in column order, bit node i from edge_start[i] */
+    int *edge_start; /* N + 1 offsets into edges */
+    int prefetch; /* Bit nodes ahead to prefetch the messages of, 0 for none */
     unsigned short max_iter;
+    ldpc_bit_t *bitval; /* Hard decisions for early termination, or NULL */
+    unsigned char sign_parity; /* Early termination without hard decisions, see cn_update_args */
+    ldpc_bit_t *unsat_all;
+    int num_threads;
+    unsigned long long *wait_cycles; /* Barrier wait time of the thread, see ldpc_stats_t */
+    unsigned char *active; /* Codeword blocks to decode (LDPC_CODEWORD_BLOCKS flags), or NULL for all */
+    ldpc_degree_run_t *runs; /* Degree runs covering first_n..first_n+num_n-1 */
+    int num_runs;
+    unsigned long long *degree_cycles; /* Update time by degree (LDPC_STATS_MAX_DEGREE entries) */
+    unsigned char *stop; /* Set to end the iterations early, see sse_ldpc_check_deadline */
     pthread_barrier_t *barr_0;
     pthread_barrier_t *barr_1;
 };
 
+struct check_satisfied_args {
+    int first_n;
+    int num_n;
+    int M;
+    ldpc_bit_t *bitval;
+    ldpc_edge_t *hb;
+    int *llr_map;
+    int *row_idx;
+    ldpc_bit_t *unsat;
+};
+
 struct bn_update_bitval_args {
     int first_n;
     int num_n;
     ldpc_edge_t *hc;
     ldpc_bit_t *bitval;
+    ldpc_bit_t *keep; /* Codewords whose hard decisions in bitval are left unchanged (0xFF lanes), or NULL */
+    ldpc_llr_t *soft; /* Soft output in the 8-bit layout, or NULL */
+    char extrinsic; /* Output extrinsic instead of a-posteriori LLRs in soft */
     ldpc_llr_t *llr;
     int N;
     ldpc_msg_t *emsg;
     int *col_idx;
+    struct check_satisfied_args *cs; /* Parity check of the final hard decisions */
+    unsigned char *active;
+    unsigned long long *wait_cycles;
+    pthread_barrier_t *barr;
 };
 
 struct cn_update_args {
@@ -98,21 +186,28 @@ struct cn_update_args {
     ldpc_msg_t *emsg;
     int *row_idx;
     unsigned short max_iter;
+    unsigned char offset; /* Offset min-sum correction */
+    unsigned short alpha; /* Normalized min-sum factor in 1/128 units */
+    ldpc_bit_t *bitval; /* Hard decisions for early termination, or NULL */
+    unsigned char sign_parity; /* With bitval set, take the parity from the message signs instead of bitval */
+    int *llr_map;
+    ldpc_bit_t *unsat;
+    ldpc_bit_t *unsat_all;
+    int num_threads;
+    /* Only set for the first thread, which records the convergence of each codeword */
+    unsigned short *conv_iter;
+    unsigned short *iterations;
+    const struct timespec *deadline; /* Deadline of the batch, or NULL */
+    unsigned char *active;
+    unsigned long long *wait_cycles;
+    ldpc_degree_run_t *runs;
+    int num_runs;
+    unsigned long long *degree_cycles;
+    unsigned char *stop;
     pthread_barrier_t *barr_0;
     pthread_barrier_t *barr_1;
 };
 
-struct check_satisfied_args {
-    int first_n;
-    int num_n;
-    int M;
-    ldpc_bit_t *bitval;
-    ldpc_edge_t *hb;
-    int *llr_map;
-    int *row_idx;
-    char *unsat_eq;
-};
-
 
 //#define IMAX(X,Y) (max(X,Y))
 //#define IMIN(X,Y) (min(X,Y))
@@ -132,6 +227,77 @@ struct check_satisfied_args {
 #define VEC_BLEND(a, b, mask) (_mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, a)))
 #endif
 
+#ifdef __SSE4__
+#define VEC_MAX_EPI8(a, b) (_mm_max_epi8(a, b))
+#else
+#define VEC_MAX_EPI8(a, b) (VEC_BLEND(b, a, _mm_cmpgt_epi8(a, b)))
+#endif
+
+
+/* Wait on a barrier, adding the TSC cycles spent waiting to *wait */
+static inline void sse_ldpc_barrier_wait(pthread_barrier_t *barr, unsigned long long *wait) {
+    unsigned long long t = __rdtsc();
+
+    pthread_barrier_wait(barr);
+    *wait += __rdtsc() - t;
+}
+
+/* Returns 1 if all codewords satisfy all parity checks according to the masks of all threads */
+static inline int sse_ldpc_all_satisfied(ldpc_bit_t *unsat_all, int num_threads) {
+    __m128i acc = _mm_setzero_si128();
+
+    for (int i = 0; i < num_threads*LDPC_CODEWORD_BLOCKS; i++)
+        acc = _mm_or_si128(acc, _mm_load_si128((__m128i *)&unsat_all[i].v));
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) == 0xFFFF;
+}
+
+/* Prefetch the messages of the edges of bit node i, msg_size bytes per edge, if it is
+ * among the bit nodes of the thread. The messages of an edge span whole cache lines.
+ */
+static inline void sse_ldpc_prefetch_bn(struct bn_update_args *arg, int i, size_t msg_size) {
+    if (i >= arg->first_n + arg->num_n)
+        return;
+    for (int j = arg->edge_start[i]; j < arg->edge_start[i+1]; j++)
+        for (size_t off = 0; off < msg_size; off += 64)
+            _mm_prefetch((const char *)arg->emsg + arg->edges[j]*msg_size + off, _MM_HINT_T0);
+}
+
+/* Parity check of hard decisions, shared by the 8-bit and 16-bit kernels */
+void sse_ldpc_check_unsatisfied(struct check_satisfied_args *arg);
+
+/* Update the convergence iteration of each codeword after a check node pass */
+void sse_ldpc_record_convergence(struct cn_update_args *arg, unsigned short iter);
+
+/* Set the stop flag once the deadline has passed. Called by the first check node thread
+ * before the barrier ending an iteration, so all threads see the same flag after it.
+ */
+static inline void sse_ldpc_check_deadline(struct cn_update_args *arg) {
+    struct timespec now;
+
+    if (!arg->deadline)
+        return;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (now.tv_sec > arg->deadline->tv_sec || (now.tv_sec == arg->deadline->tv_sec && now.tv_nsec >= arg->deadline->tv_nsec))
+        *arg->stop = 1;
+}
+
+/* Single bit node and check node updates, for decoding on the calling thread */
+void sse_ldpc_bn_pass(struct bn_update_args *arg);
+void sse_ldpc_ms_cn_pass(struct cn_update_args *arg);
+void sse_ldpc_oms_cn_pass(struct cn_update_args *arg);
+void sse_ldpc_nms_cn_pass(struct cn_update_args *arg);
+void sse16_ldpc_bn_pass(struct bn_update_args *arg);
+void sse16_ldpc_ms_cn_pass(struct cn_update_args *arg);
+void sse16_ldpc_oms_cn_pass(struct cn_update_args *arg);
+void sse16_ldpc_nms_cn_pass(struct cn_update_args *arg);
+
+/* Thread functions of the 16-bit kernels, see ldpc_sse16.c */
+void *sse16_ldpc_ms_bn_update(void *threadarg);
+void *sse16_ldpc_ms_bn_update_bitval(void *threadarg);
+void *sse16_ldpc_ms_cn_update(void *threadarg);
+void *sse16_ldpc_oms_cn_update(void *threadarg);
+void *sse16_ldpc_nms_cn_update(void *threadarg);
 
 /* Initialize memory structures */
 //void sse_ldpc_ms_load(ldpc_edge_t *hb_host, ldpc_edge_t *hc_host, int numEdges, int M, int N, int* gpu_row_idx, int *gpu_col_idx, int *gpu_llr_map);
@@ -140,7 +306,35 @@ ldpc_t *ldpc_init_sse(ldpc_param_t *param);
 /* Decode a block of LLRs */
 int ldpc_decode_sse(ldpc_t *h, char *llr, unsigned char *bitval);
 
+/* Decode a block of LLRs into soft output */
+int ldpc_decode_soft_sse(ldpc_t *h, char *llr, char *llr_out);
+
+/* Decode a block of float LLRs */
+int ldpc_decode_float_sse(ldpc_t *h, float *llr, float *frame_scale, unsigned char *bitval);
+int ldpc_decode_packed_sse(ldpc_t *h, unsigned char *llr, int bits, unsigned char *bitval);
+
+/* Continuous decoding of a stream of frames */
+long ldpc_decode_stream_sse(ldpc_t *h, int (*next)(void *ctx, char *llr),
+                            void (*done)(void *ctx, long frame, const unsigned char *bitval, const ldpc_status_t *status), void *ctx);
+
+/* Status of the codewords of the last decoded batch */
+int ldpc_decoder_status_sse(ldpc_t *h, ldpc_status_t *status);
+
+/* Decoder statistics */
+void ldpc_decoder_stats_sse(ldpc_t *h, ldpc_stats_t *stats);
+void ldpc_decoder_stats_reset_sse(ldpc_t *h);
+
+/* Deadline of the next decode call */
+void ldpc_decoder_set_deadline_sse(ldpc_t *h, const struct timespec *deadline);
+
 /* Clean up memory */
 void ldpc_destroy_sse(ldpc_t *h);
 
+/* Decoder engine shared by several codes */
+ldpc_engine_t *ldpc_engine_init_sse(unsigned short num_threads);
+int ldpc_engine_add_code_sse(ldpc_engine_t *e, ldpc_param_t *param);
+ldpc_t *ldpc_engine_code_sse(ldpc_engine_t *e, int code);
+int ldpc_engine_decode_sse(ldpc_engine_t *e, int code, char *llr_in, unsigned char *bitval);
+void ldpc_engine_destroy_sse(ldpc_engine_t *e);
+
 #endif // SSE_LDPC_H
@@ -0,0 +1,366 @@
+/*****************************************************************
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+/* 16-bit message kernels (LDPC_PRECISION_16).
+ * These mirror the 8-bit kernels in ldpc_sse.c, but process 8 codewords per vector
+ * using saturating 16-bit arithmetic, so APP sums of high-degree bit nodes do not saturate.
+ */
+
+#include "ldpc_sse.h"
+
+/* One bit node update of the columns of a thread */
+void sse16_ldpc_bn_pass(struct bn_update_args *arg) {
+
+    __m128i msg;
+    __m128i m;
+    const __m128i mesfloor = _mm_set1_epi16(-32767);
+    int start, end;
+
+    int temp;
+    ldpc_msg16_t *emsg = (ldpc_msg16_t *)arg->emsg;
+    ldpc_llr16_t *llr = (ldpc_llr16_t *)arg->llr;
+    __m128i hard_prev = _mm_setzero_si128();
+
+    /* The 16-bit kernels are not unrolled by degree, the runs are only timed for the statistics */
+    for (int r = 0; r < arg->num_runs; r++) {
+        ldpc_degree_run_t *run = &arg->runs[r];
+        unsigned long long tsc = __rdtsc();
+
+        for (int i=run->first_n; i < run->first_n + run->num_n; i++) {
+            start = arg->edge_start[i];
+            end = arg->edge_start[i+1];
+            if (arg->prefetch)
+                sse_ldpc_prefetch_bn(arg, i + arg->prefetch, sizeof(ldpc_msg16_t));
+
+            for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS_16;cw_block++) {
+                if (arg->active && !arg->active[cw_block/2])
+                    continue;
+
+                temp = (i*LDPC_CODEWORD_BLOCKS_16 + cw_block);
+
+                m = _mm_load_si128((__m128i *)&llr[temp].v);
+
+                for (int j = start; j < end; j++) {
+                    msg = _mm_load_si128((__m128i *)&emsg[arg->edges[j]].message[cw_block].v);
+
+                    m = _mm_adds_epi16(m, msg);
+                }
+
+                for (int j = start; j < end; j++) {
+                    msg = _mm_load_si128((__m128i *)&emsg[arg->edges[j]].message[cw_block].v);
+
+                    msg = _mm_subs_epi16(m, msg);
+                    //-32768 has no positive counterpart for _mm_abs_epi16
+                    msg = _mm_max_epi16(msg, mesfloor);
+
+                    _mm_store_si128((__m128i *)&emsg[arg->edges[j]].message[cw_block].v, msg);
+                }
+
+                // Hard decision for the parity check during the check node update
+                if (arg->bitval && !arg->sign_parity) {
+                    msg = _mm_srli_epi16(m, 15);
+                    if (cw_block & 1)
+                        _mm_store_si128((__m128i *)&arg->bitval[i*LDPC_CODEWORD_BLOCKS + cw_block/2].v, _mm_packs_epi16(hard_prev, msg));
+                    else
+                        hard_prev = msg;
+                }
+
+            }
+        }
+        arg->degree_cycles[IMIN(run->deg, LDPC_STATS_MAX_DEGREE - 1)] += __rdtsc() - tsc;
+    }
+}
+
+/* Bit node update without hard decision */
+void *sse16_ldpc_ms_bn_update(void *threadarg) {
+    struct bn_update_args *arg;
+    arg = (struct bn_update_args *) threadarg;
+    unsigned short iter = 0;
+    unsigned long long wait = 0;
+
+    while (iter++ < arg->max_iter)
+    {
+        sse16_ldpc_bn_pass(arg);
+        sse_ldpc_barrier_wait(arg->barr_0, &wait);
+        sse_ldpc_barrier_wait(arg->barr_1, &wait);
+
+        if (*arg->stop)
+            break;
+        if (arg->bitval && sse_ldpc_all_satisfied(arg->unsat_all, arg->num_threads))
+            break;
+    }
+
+    *arg->wait_cycles += wait;
+    return NULL;
+}
+
+/* Bit node update with hard decision */
+void *sse16_ldpc_ms_bn_update_bitval(void *threadarg) {
+
+    __m128i msg;
+    __m128i m;
+    __m128i hard_prev = _mm_setzero_si128();
+    __m128i soft_prev = _mm_setzero_si128();
+    const __m128i mesfloor = _mm_set1_epi16(-32767);
+    const __m128i soft_floor = _mm_set1_epi8(-127);
+    int col_start;
+
+    int index;
+    int temp;
+    struct bn_update_bitval_args *arg;
+    arg = (struct bn_update_bitval_args *) threadarg;
+    unsigned long long wait = 0;
+    ldpc_msg16_t *emsg = (ldpc_msg16_t *)arg->emsg;
+    ldpc_llr16_t *llr = (ldpc_llr16_t *)arg->llr;
+
+    for (int i=arg->first_n; i < arg->first_n + arg->num_n; i++) {
+        for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS_16;cw_block++) {
+            if (arg->active && !arg->active[cw_block/2])
+                continue;
+
+            col_start = arg->col_idx[i];
+            index = col_start;
+            temp = (i*LDPC_CODEWORD_BLOCKS_16 + cw_block);
+
+            m = _mm_load_si128((__m128i *)&llr[temp].v);
+
+            do {
+                msg = _mm_load_si128((__m128i *)&emsg[index].message[cw_block].v);
+
+                m = _mm_adds_epi16(m, msg);
+
+                index = arg->hc[index].i_next;
+            } while (index != col_start);
+
+            do {
+                msg = _mm_load_si128((__m128i *)&emsg[index].message[cw_block].v);
+
+                msg = _mm_subs_epi16(m, msg);
+                msg = _mm_max_epi16(msg, mesfloor);
+
+                _mm_store_si128((__m128i *)&emsg[index].message[cw_block].v, msg);
+                index = arg->hc[index].i_next;
+            } while (index != col_start);
+
+            // Hard decision
+            // bitval should be sign bit of m. Two 16-bit blocks are packed
+            // into one ldpc_bit_t block of 16 codewords.
+            msg = _mm_srli_epi16(m, 15);
+            if (cw_block & 1) {
+                ldpc_bit_t *hard = &arg->bitval[i*LDPC_CODEWORD_BLOCKS + cw_block/2];
+
+                msg = _mm_packs_epi16(hard_prev, msg);
+                if (arg->keep)
+                    msg = VEC_BLEND(msg, _mm_load_si128((__m128i *)&hard->v), _mm_load_si128((__m128i *)&arg->keep[cw_block/2].v));
+                _mm_store_si128((__m128i *)&hard->v, msg);
+            } else {
+                hard_prev = msg;
+            }
+
+            // Soft output is saturated to 8 bits and packed the same way
+            if (arg->soft) {
+                if (arg->extrinsic)
+                    m = _mm_subs_epi16(m, _mm_load_si128((__m128i *)&llr[temp].v));
+                if (cw_block & 1)
+                    _mm_store_si128((__m128i *)&arg->soft[i*LDPC_CODEWORD_BLOCKS + cw_block/2].v,
+                                    VEC_MAX_EPI8(_mm_packs_epi16(soft_prev, m), soft_floor));
+                else
+                    soft_prev = m;
+            }
+
+        }
+    }
+
+    /* Check the parity of the final hard decisions once all threads have made them */
+    sse_ldpc_barrier_wait(arg->barr, &wait);
+    sse_ldpc_check_unsatisfied(arg->cs);
+
+    *arg->wait_cycles += wait;
+    return NULL;
+}
+
+/* Scale unsigned 16-bit magnitudes by alpha/128, rounding to nearest like sse_ldpc_scale_epu8 */
+static inline __m128i sse16_ldpc_scale_epu16(__m128i x, __m128i alpha) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(64);
+    __m128i lo, hi;
+
+    lo = _mm_unpacklo_epi16(x, zero);
+    hi = _mm_unpackhi_epi16(x, zero);
+    lo = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(lo, alpha), round), 7);
+    hi = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(hi, alpha), round), 7);
+
+    return _mm_packus_epi32(lo, hi);
+}
+
+/* One check node update of the rows of a thread, for a compile-time constant algorithm */
+static inline __attribute__((always_inline)) void sse16_ldpc_cn_pass_kernel(struct cn_update_args *arg, const ldpc_algorithm_t algorithm) {
+    __m128i minLLR, nMinLLR, absol, minMsg,tmp1, tmp2, mask1, mask2, mask3, msg, sign, zero, parity;
+    const __m128i offset = _mm_set1_epi16(arg->offset);
+    const __m128i alpha = _mm_set1_epi32(arg->alpha);
+    ldpc_msg16_t *emsg = (ldpc_msg16_t *)arg->emsg;
+    const int gather = arg->bitval && !arg->sign_parity;
+
+    int row_start;
+    short counter;
+
+    if (arg->bitval)
+        for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS;cw_block++)
+            _mm_store_si128((__m128i *)&arg->unsat[cw_block].v, _mm_setzero_si128());
+
+    for (int r = 0; r < arg->num_runs; r++) {
+        ldpc_degree_run_t *run = &arg->runs[r];
+        unsigned long long tsc = __rdtsc();
+
+        for (int i=run->first_n; i < run->first_n + run->num_n; i++) {
+            for (int cw_block = 0; cw_block < LDPC_CODEWORD_BLOCKS_16;cw_block++) {
+                if (arg->active && !arg->active[cw_block/2])
+                    continue;
+                minLLR = _mm_set1_epi16(32767);
+                nMinLLR = _mm_set1_epi16(32767);
+                minMsg = _mm_setzero_si128();
+                sign =  _mm_set1_epi16(1);
+                parity = _mm_setzero_si128();
+                counter = 0;
+
+                row_start = arg->row_idx[i];
+                int index = row_start;
+
+                do {
+                    msg = _mm_load_si128((__m128i *)&emsg[index].message[cw_block].v);
+
+                    //Parity of the hard decisions, checked once per 16 codewords
+                    if (gather && !(cw_block & 1))
+                        parity = _mm_xor_si128(parity, _mm_load_si128((__m128i *)&arg->bitval[arg->llr_map[index]*LDPC_CODEWORD_BLOCKS + cw_block/2].v));
+
+                    sign = _mm_xor_si128(sign, msg);
+
+                    absol = _mm_abs_epi16(msg);
+
+                    mask1 = _mm_cmplt_epi16(absol, minLLR); //0xFFFF if less than minLLR
+                    mask2 = _mm_cmplt_epi16(absol, nMinLLR); //0xFFFF if less than nMinLLR
+
+                    tmp1 = VEC_BLEND(absol, minLLR, mask1);
+                    nMinLLR = VEC_BLEND(nMinLLR, tmp1, mask2);
+
+                    minLLR = VEC_BLEND(minLLR, absol, mask1);
+
+                    tmp1 = _mm_set1_epi16(counter);
+                    minMsg = VEC_BLEND(minMsg, tmp1, mask1);
+
+                    index = arg->hb[index].i_next;
+                    counter++;
+                } while (index != row_start);
+
+                if (algorithm == LDPC_OFFSET_MIN_SUM) {
+                    minLLR = _mm_subs_epu16(minLLR, offset);
+                    nMinLLR = _mm_subs_epu16(nMinLLR, offset);
+                } else if (algorithm == LDPC_NORMALIZED_MIN_SUM) {
+                    minLLR = sse16_ldpc_scale_epu16(minLLR, alpha);
+                    nMinLLR = sse16_ldpc_scale_epu16(nMinLLR, alpha);
+                }
+
+                counter = 0;
+                zero = _mm_setzero_si128();
+                sign = _mm_cmplt_epi16(sign,zero); //0xFFFF = -1 if < 0
+
+                //Unsatisfied: odd parity of the hard decisions, or of the incoming signs with sign_parity.
+                //The signs of the two 16-bit blocks go to the two halves of the 8-bit mask.
+                if (gather && !(cw_block & 1))
+                    _mm_store_si128((__m128i *)&arg->unsat[cw_block/2].v,
+                                    _mm_or_si128(_mm_load_si128((__m128i *)&arg->unsat[cw_block/2].v), parity));
+                else if (arg->bitval && arg->sign_parity)
+                    _mm_store_si128((__m128i *)&arg->unsat[cw_block/2].v,
+                                    _mm_or_si128(_mm_load_si128((__m128i *)&arg->unsat[cw_block/2].v),
+                                                 cw_block & 1 ? _mm_packs_epi16(zero, sign) : _mm_packs_epi16(sign, zero)));
+
+                do {
+                    msg = _mm_load_si128((__m128i *)&emsg[index].message[cw_block].v);
+
+                    mask1 = _mm_cmpeq_epi16(minMsg, _mm_set1_epi16(counter));
+                    mask2 = _mm_cmplt_epi16(msg, zero);
+                    mask3 = _mm_xor_si128(sign, mask2); //if sign*msg < 0 =>0xFFFF, else 0x0000
+                    mask3 = _mm_or_si128(mask3, _mm_set1_epi16(1));
+                    tmp1 = _mm_sign_epi16(minLLR, mask3);
+                    tmp2 = _mm_sign_epi16(nMinLLR, mask3);
+
+                    msg = VEC_BLEND(tmp1, tmp2, mask1);
+
+                    _mm_store_si128((__m128i *)&emsg[index].message[cw_block].v, msg);
+                    index = arg->hb[index].i_next;
+                    counter++;
+                } while (index != row_start);
+            }
+        }
+        arg->degree_cycles[IMIN(run->deg, LDPC_STATS_MAX_DEGREE - 1)] += __rdtsc() - tsc;
+    }
+}
+
+/* Check node update iterations of a thread */
+static inline __attribute__((always_inline)) void sse16_ldpc_cn_update_kernel(struct cn_update_args *arg, const ldpc_algorithm_t algorithm) {
+    unsigned short iter = 0;
+    unsigned long long wait = 0;
+
+    while (iter++ < arg->max_iter)
+    {
+        sse_ldpc_barrier_wait(arg->barr_0, &wait);
+        sse16_ldpc_cn_pass_kernel(arg, algorithm);
+        sse_ldpc_check_deadline(arg);
+        sse_ldpc_barrier_wait(arg->barr_1, &wait);
+
+        if (arg->conv_iter)
+            sse_ldpc_record_convergence(arg, iter);
+        if (*arg->stop)
+            break;
+        if (arg->bitval && sse_ldpc_all_satisfied(arg->unsat_all, arg->num_threads))
+            break;
+    }
+
+    *arg->wait_cycles += wait;
+}
+
+void *sse16_ldpc_ms_cn_update(void *threadarg) {
+    sse16_ldpc_cn_update_kernel((struct cn_update_args *)threadarg, LDPC_MIN_SUM);
+    return NULL;
+}
+
+void *sse16_ldpc_oms_cn_update(void *threadarg) {
+    sse16_ldpc_cn_update_kernel((struct cn_update_args *)threadarg, LDPC_OFFSET_MIN_SUM);
+    return NULL;
+}
+
+void *sse16_ldpc_nms_cn_update(void *threadarg) {
+    sse16_ldpc_cn_update_kernel((struct cn_update_args *)threadarg, LDPC_NORMALIZED_MIN_SUM);
+    return NULL;
+}
+
+void sse16_ldpc_ms_cn_pass(struct cn_update_args *arg) {
+    sse16_ldpc_cn_pass_kernel(arg, LDPC_MIN_SUM);
+}
+
+void sse16_ldpc_oms_cn_pass(struct cn_update_args *arg) {
+    sse16_ldpc_cn_pass_kernel(arg, LDPC_OFFSET_MIN_SUM);
+}
+
+void sse16_ldpc_nms_cn_pass(struct cn_update_args *arg) {
+    sse16_ldpc_cn_pass_kernel(arg, LDPC_NORMALIZED_MIN_SUM);
+}
@@ -0,0 +1,312 @@
+/*****************************************************************
+    Decode a recorded stream of LLRs from a file or stdin.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#include "ldpc.h"
+#include "alist.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define BATCH 128
+#define PAGE 4096
+
+/* One decoder batch of input */
+typedef struct {
+    const char *data; /* Input of the batch, in the mapped file or in buf */
+    char *buf; /* Buffer for streamed input and for a batch at the end of a mapped file */
+    int frames; /* Frames in the batch, 0 at the end of the input */
+    int ready; /* Filled and waiting to be decoded */
+} stream_batch_t;
+
+/* The input is read one batch ahead of the decoder, into two alternating batches */
+typedef struct {
+    int fd;
+    const char *map; /* The mapped input file, or NULL when streaming */
+    size_t map_size;
+    size_t pos; /* Bytes of the input consumed */
+    size_t frame_bytes; /* Input bytes of one codeword */
+    size_t partial; /* Bytes of an incomplete codeword at the end of the input */
+    stream_batch_t batch[2];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} stream_reader_t;
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* Read the next batch from the input */
+static void reader_fill(stream_reader_t *r, stream_batch_t *b) {
+    const size_t batch_bytes = BATCH*r->frame_bytes;
+    size_t len = 0;
+    ssize_t n;
+
+    if (r->map) {
+        len = r->map_size - r->pos;
+        if (len >= batch_bytes) {
+            /* Decode straight from the mapping, after faulting the pages in */
+            volatile const char *p = r->map + r->pos;
+            for (size_t i = 0; i < batch_bytes; i += PAGE)
+                (void)p[i];
+            b->data = r->map + r->pos;
+            b->frames = BATCH;
+            r->pos += batch_bytes;
+            return;
+        }
+        memcpy(b->buf, r->map + r->pos, len);
+    } else {
+        while (len < batch_bytes && (n = read(r->fd, b->buf + len, batch_bytes - len)) > 0)
+            len += n;
+    }
+
+    /* A batch that is not full is padded with zero LLRs, and only its frames are written out */
+    b->frames = len / r->frame_bytes;
+    r->pos += b->frames*r->frame_bytes;
+    if (b->frames < BATCH) {
+        r->partial = len - b->frames*r->frame_bytes;
+        memset(b->buf + b->frames*r->frame_bytes, 0, batch_bytes - b->frames*r->frame_bytes);
+    }
+    b->data = b->buf;
+}
+
+static void *reader_thread(void *arg) {
+    stream_reader_t *r = (stream_reader_t *)arg;
+    stream_batch_t *b;
+    int frames;
+
+    for (int n = 0; ; n++) {
+        b = &r->batch[n % 2];
+        pthread_mutex_lock(&r->lock);
+        while (b->ready)
+            pthread_cond_wait(&r->cond, &r->lock);
+        pthread_mutex_unlock(&r->lock);
+
+        reader_fill(r, b);
+        frames = b->frames;
+
+        pthread_mutex_lock(&r->lock);
+        b->ready = 1;
+        pthread_cond_broadcast(&r->cond);
+        pthread_mutex_unlock(&r->lock);
+
+        if (frames < BATCH)
+            break;
+    }
+
+    return NULL;
+}
+
+/* Write the hard decisions of a batch, one byte per bit or packed MSB first with each frame starting on a byte */
+static int write_output(FILE *out, const unsigned char *bits, int frames, int k, int packed, unsigned char *pack_buf) {
+    if (!packed)
+        return fwrite(bits, 1, (size_t)frames*k, out) == (size_t)frames*k ? 0 : -1;
+
+    size_t frame_bytes = (k + 7) / 8;
+    memset(pack_buf, 0, frames*frame_bytes);
+    for (int f = 0; f < frames; f++)
+        for (int i = 0; i < k; i++)
+            pack_buf[f*frame_bytes + i/8] |= (bits[f*k + i] & 1) << (7 - i%8);
+
+    return fwrite(pack_buf, 1, frames*frame_bytes, out) == frames*frame_bytes ? 0 : -1;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "Usage: %s -m matrix.alist [options] [input]\n"
+        "  Decodes the LLRs in input (default: stdin, also \"-\"), positive meaning a zero bit.\n"
+        "  -f format    Input format: int8, float, or int4 to int7 packed as for ldpc_decode_packed (default int8)\n"
+        "  -o file      Write the decoded data bits to file instead of stdout\n"
+        "  -P           Pack the output, 8 bits per byte MSB first, each frame starting on a byte\n"
+        "  -t threads   Decoder worker threads (default 1)\n"
+        "  -i iter      Maximum number of iterations (default 30)\n"
+        "  -a alg       Check node rule: ms, oms or nms (default ms)\n"
+        "  -p bits      Message precision: 8 or 16 (default 8)\n"
+        "  -q scale     Fixed quantization scale for float input (default 4)\n"
+        "  -A target    Adaptive quantization of float input to the given mean magnitude\n"
+        "  -C dir       Cache the code and decoder tables in dir for faster restarts\n", prog);
+}
+
+int main(int argc, char **argv) {
+    ldpc_param_t param;
+    ldpc_t *decoder;
+    stream_reader_t r;
+    pthread_t reader;
+    struct stat st;
+    char *matrix = NULL, *input = NULL;
+    FILE *out = stdout;
+    int is_float = 0, packed = 0, in_bits = 8;
+    int c, k, n;
+    long frames = 0, valid = 0;
+    double t;
+
+    ldpc_param_init(&param);
+    param.num_threads = 1;
+
+    while ((c = getopt(argc, argv, "m:f:o:Pt:i:a:p:q:A:C:h")) != -1) {
+        switch (c) {
+        case 'm': matrix = optarg; break;
+        case 'f':
+            is_float = !strcmp(optarg, "float");
+            if (!strncmp(optarg, "int", 3))
+                in_bits = atoi(optarg + 3);
+            break;
+        case 'o':
+            if (!(out = fopen(optarg, "wb"))) {
+                fprintf(stderr, "Error opening output file %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'P': packed = 1; break;
+        case 't': param.num_threads = atoi(optarg); break;
+        case 'i': param.max_iter = atoi(optarg); break;
+        case 'a':
+            if (!strcmp(optarg, "oms"))
+                param.algorithm = LDPC_OFFSET_MIN_SUM;
+            else if (!strcmp(optarg, "nms"))
+                param.algorithm = LDPC_NORMALIZED_MIN_SUM;
+            else
+                param.algorithm = LDPC_MIN_SUM;
+            break;
+        case 'p': param.precision = atoi(optarg) == 16 ? LDPC_PRECISION_16 : LDPC_PRECISION_8; break;
+        case 'q': param.llr_scaling = LDPC_LLR_SCALE_FIXED; param.llr_scale = atof(optarg); break;
+        case 'A': param.llr_scaling = LDPC_LLR_SCALE_ADAPTIVE; param.llr_target = atof(optarg); break;
+        case 'C': param.cache_dir = optarg; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!matrix || in_bits < LDPC_PACKED_MIN_BITS || in_bits > 8) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (optind < argc)
+        input = argv[optind];
+
+    param.code = ldpc_alist_load_cached(matrix, param.cache_dir);
+    if (!param.code)
+        return 1;
+    decoder = ldpc_init(&param);
+    if (!decoder)
+        return 1;
+
+    memset(&r, 0, sizeof(r));
+    r.fd = input && strcmp(input, "-") ? open(input, O_RDONLY) : STDIN_FILENO;
+    if (r.fd < 0) {
+        fprintf(stderr, "Error opening input file %s\n", input);
+        return 1;
+    }
+    if (is_float)
+        r.frame_bytes = ldpc_decoder_input_size(decoder) / BATCH * sizeof(float);
+    else
+        r.frame_bytes = ldpc_decoder_packed_input_size(decoder, in_bits) / BATCH;
+    k = ldpc_decoder_output_size(decoder) / BATCH;
+
+    /* Regular files are mapped, anything else is read */
+    if (!fstat(r.fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0) {
+        r.map_size = st.st_size;
+        r.map = (const char *)mmap(NULL, r.map_size, PROT_READ, MAP_PRIVATE, r.fd, 0);
+        if (r.map == MAP_FAILED)
+            r.map = NULL;
+        else
+            madvise((void *)r.map, r.map_size, MADV_SEQUENTIAL);
+    }
+    for (n = 0; n < 2; n++)
+        r.batch[n].buf = (char *)malloc(BATCH*r.frame_bytes);
+    pthread_mutex_init(&r.lock, NULL);
+    pthread_cond_init(&r.cond, NULL);
+
+    unsigned char *bits = (unsigned char *)malloc(ldpc_decoder_output_size(decoder));
+    unsigned char *pack_buf = (unsigned char *)malloc(BATCH*((k + 7) / 8));
+    ldpc_status_t status[BATCH];
+
+    t = now();
+    pthread_create(&reader, NULL, reader_thread, &r);
+
+    for (n = 0; ; n++) {
+        stream_batch_t *b = &r.batch[n % 2];
+
+        pthread_mutex_lock(&r.lock);
+        while (!b->ready)
+            pthread_cond_wait(&r.cond, &r.lock);
+        pthread_mutex_unlock(&r.lock);
+
+        int batch_frames = b->frames;
+        if (batch_frames) {
+            if (is_float)
+                ldpc_decode_float(decoder, (float *)b->data, NULL, bits);
+            else if (in_bits < 8)
+                ldpc_decode_packed(decoder, (unsigned char *)b->data, in_bits, bits);
+            else
+                ldpc_decode(decoder, (char *)b->data, bits);
+            ldpc_decoder_status(decoder, status);
+            for (int f = 0; f < batch_frames; f++)
+                valid += status[f].valid;
+            frames += batch_frames;
+        }
+
+        pthread_mutex_lock(&r.lock);
+        b->ready = 0;
+        pthread_cond_broadcast(&r.cond);
+        pthread_mutex_unlock(&r.lock);
+
+        if (batch_frames && write_output(out, bits, batch_frames, k, packed, pack_buf)) {
+            fprintf(stderr, "Error writing output\n");
+            return 1;
+        }
+        if (batch_frames < BATCH)
+            break;
+    }
+
+    pthread_join(reader, NULL);
+    fflush(out);
+    t = now() - t;
+
+    if (r.partial)
+        fprintf(stderr, "Ignored %zu bytes of an incomplete frame at the end of the input\n", r.partial);
+    fprintf(stderr, "Decoded %ld frames (%ld valid) in %.3f s: %.3f Mbit/s\n",
+            frames, valid, t, t > 0 ? (double)frames*k / t / 1e6 : 0.0);
+
+    if (r.map)
+        munmap((void *)r.map, r.map_size);
+    if (r.fd != STDIN_FILENO)
+        close(r.fd);
+    if (out != stdout)
+        fclose(out);
+    free(r.batch[0].buf);
+    free(r.batch[1].buf);
+    free(bits);
+    free(pack_buf);
+    ldpc_destroy(decoder);
+    ldpc_param_destroy(&param);
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*****************************************************************
+    Persistent worker threads for the decoder kernels.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#include "pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+typedef struct {
+    ldpc_pool_t *pool;
+    int index;
+} ldpc_pool_worker_t;
+
+struct ldpc_pool_t {
+    int num_workers;
+    pthread_t *threads;
+    ldpc_pool_worker_t *workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start; /* Signalled when a round of jobs is posted */
+    pthread_cond_t done; /* Signalled when the last job of a round returns */
+    unsigned long round; /* Number of rounds posted */
+    const ldpc_pool_job_t *jobs;
+    int num_jobs;
+    int running; /* Jobs of the current round not yet returned */
+    int quit;
+};
+
+static void *ldpc_pool_worker(void *arg) {
+    ldpc_pool_worker_t *w = (ldpc_pool_worker_t *)arg;
+    ldpc_pool_t *p = w->pool;
+    unsigned long round = 0;
+    ldpc_pool_job_t job;
+
+    pthread_mutex_lock(&p->lock);
+    for (;;) {
+        while (p->round == round && !p->quit)
+            pthread_cond_wait(&p->start, &p->lock);
+        if (p->quit)
+            break;
+        round = p->round;
+        if (w->index >= p->num_jobs)
+            continue;
+
+        job = p->jobs[w->index];
+        pthread_mutex_unlock(&p->lock);
+        job.fn(job.arg);
+        pthread_mutex_lock(&p->lock);
+        if (--p->running == 0)
+            pthread_cond_signal(&p->done);
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    return NULL;
+}
+
+ldpc_pool_t *ldpc_pool_create(int num_workers) {
+    ldpc_pool_t *p;
+    int rc;
+
+    p = (ldpc_pool_t *)calloc(1, sizeof(ldpc_pool_t));
+    p->threads = (pthread_t *)malloc(num_workers * sizeof(pthread_t));
+    p->workers = (ldpc_pool_worker_t *)malloc(num_workers * sizeof(ldpc_pool_worker_t));
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->start, NULL);
+    pthread_cond_init(&p->done, NULL);
+
+    for (int i = 0; i < num_workers; i++) {
+        p->workers[i].pool = p;
+        p->workers[i].index = i;
+        rc = pthread_create(&p->threads[i], NULL, ldpc_pool_worker, &p->workers[i]);
+        if (rc) {
+            fprintf(stderr, "ERROR; return code from pthread_create() is %d\n", rc);
+            ldpc_pool_destroy(p);
+            return NULL;
+        }
+        p->num_workers++;
+    }
+
+    return p;
+}
+
+void ldpc_pool_run(ldpc_pool_t *p, const ldpc_pool_job_t *jobs, int num_jobs) {
+    pthread_mutex_lock(&p->lock);
+    p->jobs = jobs;
+    p->num_jobs = num_jobs;
+    p->running = num_jobs;
+    p->round++;
+    pthread_cond_broadcast(&p->start);
+    while (p->running)
+        pthread_cond_wait(&p->done, &p->lock);
+    pthread_mutex_unlock(&p->lock);
+}
+
+void ldpc_pool_destroy(ldpc_pool_t *p) {
+    pthread_mutex_lock(&p->lock);
+    p->quit = 1;
+    pthread_cond_broadcast(&p->start);
+    pthread_mutex_unlock(&p->lock);
+
+    for (int i = 0; i < p->num_workers; i++)
+        pthread_join(p->threads[i], NULL);
+
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->start);
+    pthread_cond_destroy(&p->done);
+    free(p->threads);
+    free(p->workers);
+    free(p);
+}
@@ -0,0 +1,47 @@
+/*****************************************************************
+    Persistent worker threads for the decoder kernels.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#ifndef POOL_H
+#define POOL_H
+
+/* One thread function call */
+typedef struct {
+    void *(*fn)(void *);
+    void *arg;
+} ldpc_pool_job_t;
+
+typedef struct ldpc_pool_t ldpc_pool_t;
+
+/* Start num_workers threads. Returns NULL on failure. */
+ldpc_pool_t *ldpc_pool_create(int num_workers);
+
+/* Run job i on worker i, for all num_jobs jobs at once, and wait for all of them
+ * to return. The jobs may wait on barriers shared with each other.
+ * num_jobs must not exceed the number of workers.
+ */
+void ldpc_pool_run(ldpc_pool_t *p, const ldpc_pool_job_t *jobs, int num_jobs);
+
+/* Stop the workers */
+void ldpc_pool_destroy(ldpc_pool_t *p);
+
+#endif //POOL_H
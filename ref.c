@@ -0,0 +1,301 @@
+/*****************************************************************
+    Scalar reference decoder for checking the SIMD decoder.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#include "ref.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+#define LDPC_REF_NOT_CONVERGED -1
+
+struct ldpc_ref_t {
+    int M, N, num_edges;
+    int *row_start; /* M+1 offsets, the edges are numbered in row order as in ldpc_code_t */
+    int *edge_col; /* Column of each edge */
+    int *col_start; /* N+1 offsets into col_edges */
+    int *col_edges; /* Edges of each column by increasing row, the order of the decoder's sums */
+
+    ldpc_ref_arith_t arith;
+    ldpc_algorithm_t algorithm;
+    int offset;
+    unsigned short alpha; /* In 1/128 units, as in the integer kernels */
+    float alpha_f;
+    unsigned short max_iter;
+    unsigned char early_termination;
+    unsigned char extrinsic;
+
+    /* Messages, a-posteriori LLRs and hard decisions of the codeword being decoded */
+    int *msg;
+    int *app;
+    float *msg_f;
+    float *app_f;
+    unsigned char *hard;
+};
+
+static inline int ldpc_ref_clamp(int x, int lo, int hi) {
+    return x > hi ? hi : x < lo ? lo : x;
+}
+
+/* Saturate to the message range of the integer arithmetic */
+static inline int ldpc_ref_sat(const ldpc_ref_t *r, int x) {
+    int lim = r->arith == LDPC_REF_INT16 ? 32767 : 127;
+
+    return ldpc_ref_clamp(x, -lim - 1, lim);
+}
+
+ldpc_ref_t *ldpc_ref_create(ldpc_param_t *param, ldpc_ref_arith_t arith) {
+    ldpc_code_t *H = ldpc_param_code(param);
+    ldpc_ref_t *r;
+
+    if (!H) {
+        fprintf(stderr, "No LDPC code supplied!\n");
+        return NULL;
+    }
+
+    r = (ldpc_ref_t *)calloc(1, sizeof(ldpc_ref_t));
+    r->M = H->M;
+    r->N = H->N;
+    r->num_edges = H->num_edges;
+    r->arith = arith;
+    r->algorithm = param->algorithm;
+    r->offset = ldpc_ref_clamp(param->offset, 0, 127);
+    r->alpha = (unsigned short)(param->alpha*128.0f + 0.5f);
+    r->alpha_f = param->alpha;
+    r->max_iter = ldpc_ref_clamp(param->max_iter, 0, 100);
+    r->early_termination = param->early_termination;
+    r->extrinsic = param->soft_output == LDPC_SOFT_EXTRINSIC;
+
+    r->row_start = (int *)malloc((H->M + 1)*sizeof(int));
+    r->edge_col = (int *)malloc(H->num_edges*sizeof(int));
+    r->col_start = (int *)malloc((H->N + 1)*sizeof(int));
+    r->col_edges = (int *)malloc(H->num_edges*sizeof(int));
+    memcpy(r->row_start, H->row_start, (H->M + 1)*sizeof(int));
+    memcpy(r->col_start, H->col_start, (H->N + 1)*sizeof(int));
+    for (int e = 0; e < H->num_edges; e++) {
+        r->edge_col[e] = ldpc_code_index(H, H->row_col, e);
+        r->col_edges[e] = ldpc_code_index(H, H->col_edge, e);
+    }
+
+    if (arith == LDPC_REF_FLOAT) {
+        r->msg_f = (float *)malloc(H->num_edges*sizeof(float));
+        r->app_f = (float *)malloc(H->N*sizeof(float));
+    } else {
+        r->msg = (int *)malloc(H->num_edges*sizeof(int));
+        r->app = (int *)malloc(H->N*sizeof(int));
+    }
+    r->hard = (unsigned char *)malloc(H->N);
+
+    return r;
+}
+
+/* Bit node update: a-posteriori LLRs, hard decisions and extrinsic messages */
+static void ldpc_ref_bn_pass(ldpc_ref_t *r, const float *llr) {
+    for (int j = 0; j < r->N; j++) {
+        int first = r->col_start[j], last = r->col_start[j+1];
+
+        if (r->arith == LDPC_REF_FLOAT) {
+            float m = llr[j];
+
+            for (int k = first; k < last; k++)
+                m += r->msg_f[r->col_edges[k]];
+            for (int k = first; k < last; k++)
+                r->msg_f[r->col_edges[k]] = m - r->msg_f[r->col_edges[k]];
+            r->app_f[j] = m;
+            r->hard[j] = m < 0.0f;
+        } else {
+            int m = (int)llr[j];
+
+            /* Saturating sums are order dependent, the edges are added in the decoder's order */
+            for (int k = first; k < last; k++)
+                m = ldpc_ref_sat(r, m + r->msg[r->col_edges[k]]);
+            for (int k = first; k < last; k++) {
+                int e = r->col_edges[k];
+                if (r->arith == LDPC_REF_INT8)
+                    r->msg[e] = ldpc_ref_sat(r, ldpc_ref_sat(r, m - r->msg[e]) + 1); /* No -128, as in the 8-bit kernels */
+                else
+                    r->msg[e] = ldpc_ref_clamp(m - r->msg[e], -32767, 32767);
+            }
+            r->app[j] = m;
+            r->hard[j] = m < 0;
+        }
+    }
+}
+
+/* Min-sum correction of a magnitude of the integer arithmetic */
+static inline int ldpc_ref_correct(const ldpc_ref_t *r, int x) {
+    if (r->algorithm == LDPC_OFFSET_MIN_SUM)
+        return x > r->offset ? x - r->offset : 0;
+    if (r->algorithm == LDPC_NORMALIZED_MIN_SUM)
+        return (x*r->alpha + 64) >> 7;
+    return x;
+}
+
+/* Check node update. The edge sending the minimum magnitude gets the second minimum,
+ * when several edges share the minimum both are the same.
+ */
+static void ldpc_ref_cn_pass(ldpc_ref_t *r) {
+    for (int i = 0; i < r->M; i++) {
+        int first = r->row_start[i], last = r->row_start[i+1];
+        int neg = 0;
+
+        if (r->arith == LDPC_REF_FLOAT) {
+            float min = FLT_MAX, nmin = FLT_MAX, a;
+
+            for (int e = first; e < last; e++) {
+                a = r->msg_f[e] < 0.0f ? -r->msg_f[e] : r->msg_f[e];
+                neg ^= r->msg_f[e] < 0.0f;
+                if (a < min) {
+                    nmin = min;
+                    min = a;
+                } else if (a < nmin) {
+                    nmin = a;
+                }
+            }
+
+            float cmin = min, cnmin = nmin;
+            if (r->algorithm == LDPC_OFFSET_MIN_SUM) {
+                cmin = cmin > r->offset ? cmin - r->offset : 0.0f;
+                cnmin = cnmin > r->offset ? cnmin - r->offset : 0.0f;
+            } else if (r->algorithm == LDPC_NORMALIZED_MIN_SUM) {
+                cmin *= r->alpha_f;
+                cnmin *= r->alpha_f;
+            }
+
+            for (int e = first; e < last; e++) {
+                a = r->msg_f[e] < 0.0f ? -r->msg_f[e] : r->msg_f[e];
+                a = a == min ? cnmin : cmin;
+                r->msg_f[e] = neg ^ (r->msg_f[e] < 0.0f) ? -a : a;
+            }
+        } else {
+            int lim = r->arith == LDPC_REF_INT16 ? 32767 : 127;
+            int min = lim, nmin = lim, a;
+
+            for (int e = first; e < last; e++) {
+                a = abs(r->msg[e]);
+                neg ^= r->msg[e] < 0;
+                if (a < min) {
+                    nmin = min;
+                    min = a;
+                } else if (a < nmin) {
+                    nmin = a;
+                }
+            }
+
+            int cmin = ldpc_ref_correct(r, min), cnmin = ldpc_ref_correct(r, nmin);
+
+            for (int e = first; e < last; e++) {
+                a = abs(r->msg[e]) == min ? cnmin : cmin;
+                r->msg[e] = neg ^ (r->msg[e] < 0) ? -a : a;
+            }
+        }
+    }
+}
+
+/* Returns 1 if the hard decisions satisfy all parity checks */
+static int ldpc_ref_satisfied(const ldpc_ref_t *r) {
+    for (int i = 0; i < r->M; i++) {
+        int parity = 0;
+
+        for (int e = r->row_start[i]; e < r->row_start[i+1]; e++)
+            parity ^= r->hard[r->edge_col[e]];
+        if (parity)
+            return 0;
+    }
+
+    return 1;
+}
+
+int ldpc_ref_decode(ldpc_ref_t *r, const float *llr, int iterations, unsigned char *bitval, float *soft, ldpc_status_t *status) {
+    int max_iter = iterations ? iterations : r->max_iter;
+    int conv_iter = LDPC_REF_NOT_CONVERGED;
+    int iter, valid, checked;
+
+    if (r->arith == LDPC_REF_FLOAT)
+        memset(r->msg_f, 0, r->num_edges*sizeof(float));
+    else
+        memset(r->msg, 0, r->num_edges*sizeof(int));
+
+    for (iter = 1; iter <= max_iter; iter++) {
+        ldpc_ref_bn_pass(r, llr);
+        ldpc_ref_cn_pass(r);
+
+        if (r->early_termination) {
+            /* The checked hard decisions were made before this iteration's check node update */
+            if (!ldpc_ref_satisfied(r))
+                conv_iter = LDPC_REF_NOT_CONVERGED;
+            else if (conv_iter == LDPC_REF_NOT_CONVERGED)
+                conv_iter = iter - 1;
+            if (!iterations && conv_iter != LDPC_REF_NOT_CONVERGED)
+                break;
+        }
+    }
+    if (iter > max_iter)
+        iter = max_iter;
+
+    /* Hard decisions that passed the last check are returned as checked. The others, and
+     * the soft output, come from one more bit node pass.
+     */
+    checked = conv_iter != LDPC_REF_NOT_CONVERGED;
+    if (checked)
+        memcpy(bitval, r->hard, r->N);
+    if (!checked || soft)
+        ldpc_ref_bn_pass(r, llr);
+    if (!checked)
+        memcpy(bitval, r->hard, r->N);
+    valid = checked || ldpc_ref_satisfied(r);
+
+    if (soft) {
+        for (int j = 0; j < r->N; j++) {
+            if (r->arith == LDPC_REF_FLOAT) {
+                soft[j] = r->extrinsic ? r->app_f[j] - llr[j] : r->app_f[j];
+            } else {
+                int m = r->app[j];
+                if (r->extrinsic)
+                    m = ldpc_ref_sat(r, m - (int)llr[j]);
+                soft[j] = ldpc_ref_clamp(m, -127, 127); /* 8-bit soft output in both precisions */
+            }
+        }
+    }
+
+    if (status) {
+        status->valid = valid;
+        status->cut_off = 0;
+        status->iterations = valid && conv_iter != LDPC_REF_NOT_CONVERGED ? conv_iter : iter;
+    }
+
+    return valid;
+}
+
+void ldpc_ref_destroy(ldpc_ref_t *r) {
+    free(r->row_start);
+    free(r->edge_col);
+    free(r->col_start);
+    free(r->col_edges);
+    free(r->msg);
+    free(r->app);
+    free(r->msg_f);
+    free(r->app_f);
+    free(r->hard);
+    free(r);
+}
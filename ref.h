@@ -0,0 +1,65 @@
+/*****************************************************************
+    Scalar reference decoder for checking the SIMD decoder.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#ifndef REF_H
+#define REF_H
+
+#include "ldpc.h"
+
+/* Arithmetic of the reference decoder */
+typedef enum {
+    LDPC_REF_FLOAT = 0,         /* Min-sum on unquantized float messages */
+    LDPC_REF_INT8,              /* The saturating 8-bit arithmetic of LDPC_PRECISION_8 */
+    LDPC_REF_INT16              /* The saturating 16-bit arithmetic of LDPC_PRECISION_16 */
+} ldpc_ref_arith_t;
+
+/* A flooding min-sum decoder of one codeword at a time, written for clarity rather than
+ * speed. In integer arithmetic it repeats the operations of the kernels in ldpc_sse.c
+ * and ldpc_sse16.c in the same order, so its output is bit-exact with ldpc_decode and
+ * ldpc_decode_soft on the same input, as long as the decoder uses no node reordering,
+ * shortening, puncturing, bit-flipping stage, deadline, iteration budget or sign_parity.
+ */
+typedef struct ldpc_ref_t ldpc_ref_t;
+
+/* Create a reference decoder for the code, algorithm, offset, alpha, max_iter,
+ * early_termination and soft_output of param. Returns NULL on failure.
+ */
+ldpc_ref_t *ldpc_ref_create(ldpc_param_t *param, ldpc_ref_arith_t arith);
+
+/* Decode one codeword of N LLRs in the bit order of H (positive means a zero bit).
+ * In integer arithmetic, the LLRs are the integer input values of ldpc_decode.
+ * bitval receives the N hard decisions, and soft, unless NULL, the N a-posteriori or
+ * extrinsic LLRs, saturated like the output of ldpc_decode_soft in integer arithmetic.
+ * With iterations 0, up to max_iter iterations are run, ending with early termination
+ * once the hard decisions satisfy all checks. Otherwise exactly iterations iterations
+ * are run, as in a batch of ldpc_decode that ran that many, and status is set the way
+ * ldpc_decoder_status sets it after ldpc_decode of such a batch. status may be NULL.
+ * As in the decoder, hard decisions that passed the parity check of the last iteration
+ * are returned as checked, and the soft output comes from one more bit node update.
+ * Returns 1 if the hard decisions satisfy all parity checks and 0 otherwise.
+ */
+int ldpc_ref_decode(ldpc_ref_t *r, const float *llr, int iterations, unsigned char *bitval, float *soft, ldpc_status_t *status);
+
+void ldpc_ref_destroy(ldpc_ref_t *r);
+
+#endif //REF_H
@@ -0,0 +1,173 @@
+/*****************************************************************
+    Renumbering of the nodes of an LDPC code for memory locality.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#include "reorder.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* The Tanner graph in adjacency list form. Nodes 0..M-1 are the check nodes,
+ * and nodes M..M+N-1 the bit nodes.
+ */
+typedef struct {
+    int num_nodes;
+    int *first; /* Neighbors of node v are adj[first[v]] .. adj[first[v+1]-1] */
+    int *adj;
+} tanner_graph_t;
+
+static int tanner_graph_init(tanner_graph_t *g, ldpc_code_t *H) {
+    int *edge_row;
+    int v, e, k = 0;
+
+    g->num_nodes = H->M + H->N;
+    g->first = (int *)malloc((g->num_nodes + 1)*sizeof(int));
+    g->adj = (int *)malloc(2*H->num_edges*sizeof(int));
+    edge_row = (int *)malloc(H->num_edges*sizeof(int));
+    if (!g->first || !g->adj || !edge_row) {
+        free(g->first);
+        free(g->adj);
+        free(edge_row);
+        return -1;
+    }
+
+    for (v = 0; v < H->M; v++) {
+        g->first[v] = k;
+        for (e = H->row_start[v]; e < H->row_start[v + 1]; e++) {
+            g->adj[k++] = H->M + ldpc_code_index(H, H->row_col, e);
+            edge_row[e] = v;
+        }
+    }
+    for (v = 0; v < H->N; v++) {
+        g->first[H->M + v] = k;
+        for (e = H->col_start[v]; e < H->col_start[v + 1]; e++)
+            g->adj[k++] = edge_row[ldpc_code_index(H, H->col_edge, e)];
+    }
+    g->first[g->num_nodes] = k;
+
+    free(edge_row);
+    return 0;
+}
+
+static inline int tanner_degree(tanner_graph_t *g, int v) {
+    return g->first[v + 1] - g->first[v];
+}
+
+/* Reverse Cuthill-McKee: breadth-first search from a low degree node, visiting the
+ * neighbors of each node in order of increasing degree, and reversing the result.
+ * Nodes close in the graph end up close in the order, which keeps the edges of
+ * a bit node close to each other and to those of its neighbors.
+ */
+static void tanner_rcm(tanner_graph_t *g, int *order) {
+    char *visited = (char *)calloc(g->num_nodes, sizeof(char));
+    int head = 0, tail = 0;
+    int v, u, i, j, start;
+
+    while (tail < g->num_nodes) {
+        /* Start each connected component at its lowest degree node */
+        start = -1;
+        for (v = 0; v < g->num_nodes; v++)
+            if (!visited[v] && (start < 0 || tanner_degree(g, v) < tanner_degree(g, start)))
+                start = v;
+        visited[start] = 1;
+        order[tail++] = start;
+
+        while (head < tail) {
+            v = order[head++];
+            i = tail;
+            for (j = g->first[v]; j < g->first[v + 1]; j++) {
+                u = g->adj[j];
+                if (visited[u])
+                    continue;
+                visited[u] = 1;
+
+                /* Insertion sort by degree, the neighbor lists are short */
+                int k = tail++;
+                while (k > i && tanner_degree(g, order[k - 1]) > tanner_degree(g, u)) {
+                    order[k] = order[k - 1];
+                    k--;
+                }
+                order[k] = u;
+            }
+        }
+    }
+
+    for (i = 0; i < g->num_nodes/2; i++) {
+        v = order[i];
+        order[i] = order[g->num_nodes - 1 - i];
+        order[g->num_nodes - 1 - i] = v;
+    }
+
+    free(visited);
+}
+
+/* Stable order of the nodes first..first+num-1 by decreasing degree */
+static void tanner_degree_order(tanner_graph_t *g, int first, int num, int *order) {
+    int max_deg = 0, k = 0;
+
+    for (int v = first; v < first + num; v++)
+        if (tanner_degree(g, v) > max_deg)
+            max_deg = tanner_degree(g, v);
+
+    for (int d = max_deg; d >= 0; d--)
+        for (int v = first; v < first + num; v++)
+            if (tanner_degree(g, v) == d)
+                order[k++] = v - first;
+}
+
+int ldpc_reorder(ldpc_code_t *H, ldpc_reorder_t method, int *row_order, int *col_order) {
+    tanner_graph_t g;
+    int *order;
+    int i, r = 0, c = 0;
+
+    if (method == LDPC_REORDER_NONE) {
+        for (i = 0; i < H->M; i++)
+            row_order[i] = i;
+        for (i = 0; i < H->N; i++)
+            col_order[i] = i;
+        return 0;
+    }
+
+    if (tanner_graph_init(&g, H)) {
+        fprintf(stderr, "Out of memory while reordering the code\n");
+        return -1;
+    }
+
+    if (method == LDPC_REORDER_DEGREE) {
+        tanner_degree_order(&g, 0, H->M, row_order);
+        tanner_degree_order(&g, H->M, H->N, col_order);
+    } else {
+        order = (int *)malloc(g.num_nodes*sizeof(int));
+        tanner_rcm(&g, order);
+        for (i = 0; i < g.num_nodes; i++) {
+            if (order[i] < H->M)
+                row_order[r++] = order[i];
+            else
+                col_order[c++] = order[i] - H->M;
+        }
+        free(order);
+    }
+
+    free(g.first);
+    free(g.adj);
+
+    return 0;
+}
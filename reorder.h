@@ -0,0 +1,36 @@
+/*****************************************************************
+    Renumbering of the nodes of an LDPC code for memory locality.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#ifndef REORDER_H
+#define REORDER_H
+
+#include "ldpc.h"
+
+/* Compute a new order of the rows (check nodes) and columns (bit nodes) of H.
+ * row_order[i] receives the original row placed at position i, and col_order[j]
+ * the original column placed at position j.
+ * Returns 0 on success and -1 otherwise.
+ */
+int ldpc_reorder(ldpc_code_t *H, ldpc_reorder_t method, int *row_order, int *col_order);
+
+#endif //REORDER_H
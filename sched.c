@@ -0,0 +1,303 @@
+/*****************************************************************
+    Scheduling of the batches of many decoders on one set of worker threads.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#include "sched.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Pass increment of a channel of weight 1 per batch */
+#define LDPC_SCHED_STRIDE (1UL << 20)
+
+typedef struct ldpc_sched_task_t {
+    char *llr;
+    unsigned char *bitval;
+    void (*done)(void *ctx, int num_valid);
+    void *ctx;
+    unsigned long long submit_us;
+    struct ldpc_sched_task_t *next;
+} ldpc_sched_task_t;
+
+struct ldpc_sched_channel_t {
+    ldpc_sched_t *s;
+    ldpc_t *h;
+    int priority;
+    unsigned long stride;
+    unsigned long long pass; /* Virtual time of the channel's next batch */
+    int last_worker; /* Worker that decoded the previous batch, or -1 */
+
+    ldpc_sched_task_t *head, *tail; /* Batches waiting */
+    unsigned char running; /* A batch is being decoded */
+    pthread_cond_t idle; /* Signalled when no batches are waiting or running */
+
+    ldpc_sched_stats_t stats;
+    struct ldpc_sched_channel_t *next;
+};
+
+typedef struct {
+    ldpc_sched_t *s;
+    int index;
+    int min_priority; /* Lowest priority served by the worker */
+} ldpc_sched_worker_t;
+
+struct ldpc_sched_t {
+    int num_workers;
+    pthread_t *threads;
+    ldpc_sched_worker_t *workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work; /* Signalled when a channel may have become runnable */
+    ldpc_sched_channel_t *channels;
+    unsigned long long vtime; /* Pass of the last batch started */
+    int quit;
+};
+
+static unsigned long long ldpc_sched_now_us(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec*1000000ULL + t.tv_nsec/1000;
+}
+
+/* Choose the channel a worker decodes next, or NULL if none is runnable. Called with the lock held. */
+static ldpc_sched_channel_t *ldpc_sched_pick(ldpc_sched_t *s, ldpc_sched_worker_t *w) {
+    ldpc_sched_channel_t *best = NULL;
+
+    for (ldpc_sched_channel_t *c = s->channels; c; c = c->next) {
+        if (!c->head || c->running || c->priority < w->min_priority)
+            continue;
+        if (!best || c->priority > best->priority)
+            best = c;
+        else if (c->priority == best->priority) {
+            /* Least pass first, and among equals the channel last decoded by this worker */
+            if (c->pass < best->pass || (c->pass == best->pass && c->last_worker == w->index))
+                best = c;
+        }
+    }
+
+    return best;
+}
+
+static void *ldpc_sched_worker(void *arg) {
+    ldpc_sched_worker_t *w = (ldpc_sched_worker_t *)arg;
+    ldpc_sched_t *s = w->s;
+    ldpc_sched_channel_t *c;
+    ldpc_sched_task_t *task;
+    unsigned long long start, wait;
+    int num_valid;
+
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        while (!s->quit && !(c = ldpc_sched_pick(s, w)))
+            pthread_cond_wait(&s->work, &s->lock);
+        if (s->quit)
+            break;
+
+        task = c->head;
+        c->head = task->next;
+        if (!c->head)
+            c->tail = NULL;
+        c->running = 1;
+        c->last_worker = w->index;
+        s->vtime = c->pass;
+        c->pass += c->stride;
+        pthread_mutex_unlock(&s->lock);
+
+        start = ldpc_sched_now_us();
+        num_valid = ldpc_decode(c->h, task->llr, task->bitval);
+        wait = start - task->submit_us;
+        if (task->done)
+            task->done(task->ctx, num_valid);
+
+        pthread_mutex_lock(&s->lock);
+        c->stats.batches++;
+        c->stats.queue_us += wait;
+        if (wait > c->stats.max_queue_us)
+            c->stats.max_queue_us = wait;
+        c->stats.decode_us += ldpc_sched_now_us() - start;
+        c->running = 0;
+        if (c->head)
+            pthread_cond_broadcast(&s->work);
+        else
+            pthread_cond_broadcast(&c->idle);
+        free(task);
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    return NULL;
+}
+
+ldpc_sched_t *ldpc_sched_create(int num_workers) {
+    ldpc_sched_t *s;
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int rc;
+
+    if (num_cpus <= 0)
+        num_cpus = 1;
+    /* More workers than CPUs would only preempt each other in the middle of batches */
+    if (num_workers <= 0 || num_workers > num_cpus)
+        num_workers = num_cpus;
+
+    s = (ldpc_sched_t *)calloc(1, sizeof(ldpc_sched_t));
+    s->threads = (pthread_t *)malloc(num_workers * sizeof(pthread_t));
+    s->workers = (ldpc_sched_worker_t *)malloc(num_workers * sizeof(ldpc_sched_worker_t));
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->work, NULL);
+
+    for (int i = 0; i < num_workers; i++) {
+        s->workers[i].s = s;
+        s->workers[i].index = i;
+        s->workers[i].min_priority = INT_MIN;
+        rc = pthread_create(&s->threads[i], NULL, ldpc_sched_worker, &s->workers[i]);
+        if (rc) {
+            fprintf(stderr, "ERROR; return code from pthread_create() is %d\n", rc);
+            ldpc_sched_destroy(s);
+            return NULL;
+        }
+        s->num_workers++;
+    }
+
+    return s;
+}
+
+int ldpc_sched_reserve(ldpc_sched_t *s, int num_workers, int min_priority) {
+    if (num_workers < 0 || num_workers >= s->num_workers) {
+        fprintf(stderr, "Cannot reserve %d of %d workers\n", num_workers, s->num_workers);
+        return -1;
+    }
+
+    pthread_mutex_lock(&s->lock);
+    for (int i = 0; i < s->num_workers; i++)
+        s->workers[i].min_priority = i < s->num_workers - num_workers ? INT_MIN : min_priority;
+    pthread_cond_broadcast(&s->work);
+    pthread_mutex_unlock(&s->lock);
+
+    return 0;
+}
+
+ldpc_sched_channel_t *ldpc_sched_attach(ldpc_sched_t *s, ldpc_t *h, int priority, unsigned int weight) {
+    ldpc_sched_channel_t *c;
+
+    if (!h)
+        return NULL;
+    if (ldpc_decoder_num_threads(h)) {
+        fprintf(stderr, "Cannot attach a decoder with %d worker threads, use num_threads 0\n",
+                ldpc_decoder_num_threads(h));
+        return NULL;
+    }
+
+    c = (ldpc_sched_channel_t *)calloc(1, sizeof(ldpc_sched_channel_t));
+    c->s = s;
+    c->h = h;
+    c->priority = priority;
+    c->stride = LDPC_SCHED_STRIDE / (weight ? weight : 1);
+    c->last_worker = -1;
+    pthread_cond_init(&c->idle, NULL);
+
+    pthread_mutex_lock(&s->lock);
+    c->pass = s->vtime;
+    c->next = s->channels;
+    s->channels = c;
+    pthread_mutex_unlock(&s->lock);
+
+    return c;
+}
+
+int ldpc_sched_submit(ldpc_sched_channel_t *c, char *llr, unsigned char *bitval,
+                      void (*done)(void *ctx, int num_valid), void *ctx) {
+    ldpc_sched_t *s = c->s;
+    ldpc_sched_task_t *task = (ldpc_sched_task_t *)malloc(sizeof(ldpc_sched_task_t));
+
+    if (!task)
+        return -1;
+    task->llr = llr;
+    task->bitval = bitval;
+    task->done = done;
+    task->ctx = ctx;
+    task->next = NULL;
+    task->submit_us = ldpc_sched_now_us();
+
+    pthread_mutex_lock(&s->lock);
+    /* A channel that was idle does not get credit for the time it had nothing to decode */
+    if (!c->head && !c->running && c->pass < s->vtime)
+        c->pass = s->vtime;
+    if (c->tail)
+        c->tail->next = task;
+    else
+        c->head = task;
+    c->tail = task;
+    pthread_cond_broadcast(&s->work);
+    pthread_mutex_unlock(&s->lock);
+
+    return 0;
+}
+
+void ldpc_sched_wait(ldpc_sched_channel_t *c) {
+    ldpc_sched_t *s = c->s;
+
+    pthread_mutex_lock(&s->lock);
+    while (c->head || c->running)
+        pthread_cond_wait(&c->idle, &s->lock);
+    pthread_mutex_unlock(&s->lock);
+}
+
+void ldpc_sched_stats(ldpc_sched_channel_t *c, ldpc_sched_stats_t *stats) {
+    pthread_mutex_lock(&c->s->lock);
+    *stats = c->stats;
+    pthread_mutex_unlock(&c->s->lock);
+}
+
+void ldpc_sched_detach(ldpc_sched_channel_t *c) {
+    ldpc_sched_t *s = c->s;
+    ldpc_sched_channel_t **p;
+
+    ldpc_sched_wait(c);
+
+    pthread_mutex_lock(&s->lock);
+    for (p = &s->channels; *p != c; p = &(*p)->next)
+        ;
+    *p = c->next;
+    pthread_mutex_unlock(&s->lock);
+
+    pthread_cond_destroy(&c->idle);
+    free(c);
+}
+
+void ldpc_sched_destroy(ldpc_sched_t *s) {
+    pthread_mutex_lock(&s->lock);
+    s->quit = 1;
+    pthread_cond_broadcast(&s->work);
+    pthread_mutex_unlock(&s->lock);
+
+    for (int i = 0; i < s->num_workers; i++)
+        pthread_join(s->threads[i], NULL);
+
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->work);
+    free(s->threads);
+    free(s->workers);
+    free(s);
+}
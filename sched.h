@@ -0,0 +1,83 @@
+/*****************************************************************
+    Scheduling of the batches of many decoders on one set of worker threads.
+
+    Copyright (C) 2014 Stefan Grönroos
+
+    Authors: Stefan Grönroos <stefan.gronroos@abo.fi>
+
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+********************************************************************/
+
+#ifndef SCHED_H
+#define SCHED_H
+
+#include "ldpc.h"
+
+/* A fixed set of worker threads shared by all decoders of a process. Each decoder is
+ * attached as a channel, and its batches are decoded in submission order, one at a time.
+ * An idle worker takes the next batch of any channel: the highest priority first, and
+ * among channels of equal priority the one with the least decoding time relative to its
+ * weight. Decoders attached to a scheduler must be initialized with num_threads 0,
+ * so that each batch runs on the worker alone and the worker count bounds the number
+ * of decoding threads.
+ */
+typedef struct ldpc_sched_t ldpc_sched_t;
+typedef struct ldpc_sched_channel_t ldpc_sched_channel_t;
+
+/* Statistics of a channel since ldpc_sched_attach */
+typedef struct {
+    unsigned long long batches; /* Batches decoded */
+    unsigned long long queue_us; /* Time from submission to decoding, summed over batches */
+    unsigned long long max_queue_us; /* Longest time from submission to decoding */
+    unsigned long long decode_us; /* Decoding time, summed over batches */
+} ldpc_sched_stats_t;
+
+/* Start num_workers worker threads, at most one per online CPU, or one per online CPU
+ * if num_workers is 0. Returns NULL on failure.
+ */
+ldpc_sched_t *ldpc_sched_create(int num_workers);
+
+/* Reserve num_workers of the workers for channels of priority min_priority and above.
+ * At least one worker must remain for all channels. Returns 0 on success and -1 otherwise.
+ */
+int ldpc_sched_reserve(ldpc_sched_t *s, int num_workers, int min_priority);
+
+/* Attach a decoder. Channels of higher priority are always served first, and channels of
+ * equal priority get decoding time in proportion to their weight (at least 1).
+ * Returns NULL on failure, or if the decoder has worker threads of its own.
+ */
+ldpc_sched_channel_t *ldpc_sched_attach(ldpc_sched_t *s, ldpc_t *h, int priority, unsigned int weight);
+
+/* Queue a batch for ldpc_decode. llr and bitval must stay valid until done has been called,
+ * on the worker thread, with the return value of ldpc_decode. done may be NULL.
+ * Returns 0 on success and -1 otherwise.
+ */
+int ldpc_sched_submit(ldpc_sched_channel_t *c, char *llr, unsigned char *bitval,
+                      void (*done)(void *ctx, int num_valid), void *ctx);
+
+/* Wait until all batches submitted to the channel are decoded */
+void ldpc_sched_wait(ldpc_sched_channel_t *c);
+
+/* Get the statistics of a channel */
+void ldpc_sched_stats(ldpc_sched_channel_t *c, ldpc_sched_stats_t *stats);
+
+/* Wait for the batches of the channel and detach it. The decoder is not freed. */
+void ldpc_sched_detach(ldpc_sched_channel_t *c);
+
+/* Stop the workers and free the scheduler. All channels must be detached. */
+void ldpc_sched_destroy(ldpc_sched_t *s);
+
+#endif //SCHED_H
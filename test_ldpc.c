@@ -25,15 +25,23 @@
 #include "ldpc.h" /* LDPC decoder interface */
 #include "alist.h"
 #include "ldpc.h"
+#include "sched.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
 
 #define ROUNDS 5
+#define SCHED_CHANNELS 3
+#define SCHED_BATCHES 2
+
+/* Called on the scheduler's worker thread when a batch has been decoded */
+static void sched_done(void *ctx, int num_valid) {
+    *(int *)ctx = num_valid;
+}
 
 int main() {
-    ldpc_ll_matrix_t *H;
+    ldpc_code_t *H;
     ldpc_param_t param;
     ldpc_t *decoder;
     char *input;
@@ -44,12 +52,21 @@ int main() {
     float ber;
     int sum, csum = 0;
     int rounds = 0;
+    int valid;
+    ldpc_stats_t stats;
+    ldpc_sched_t *sched;
+    ldpc_t *sched_dec[SCHED_CHANNELS];
+    ldpc_sched_channel_t *sched_chan[SCHED_CHANNELS];
+    unsigned char *sched_out[SCHED_CHANNELS][SCHED_BATCHES];
+    int sched_valid[SCHED_CHANNELS][SCHED_BATCHES];
+    ldpc_sched_stats_t sched_stats;
+    int c, b, failed = 0;
 
     srand(time(NULL));
 
     /***
      * First, we load an LDPC code, i.e. its associated parity-check matrix
-     * into a linked-list-based format from a .alist file.
+     * into a compact format from a .alist file.
      * The parity check matrix determines the number of data and parity bits in a
      * coded bit sequence (a codeword).
      * N (the number of columns in the parity check matrix) determines the total
@@ -57,18 +74,18 @@ int main() {
      * the number of parity (redundancy) bits. N-M = K is the number of data (input)
      * bits.
      ***/
-    H = ldpc_alist_parse("matrices/dvbs2_LDPC_matrix_12.alist");
+    H = ldpc_alist_load("matrices/dvbs2_LDPC_matrix_12.alist");
     if (!H)
         return 1;
 
     /***
      * An ldpc_param_t structure contains various parameters used to set up the
      * decoder instance. The most important parameter is a parity check matrix
-     * in the ldpc_ll_matrix_t format, as produced by for example the ldpc_alist_parse
+     * in the ldpc_code_t format, as produced by for example the ldpc_alist_load
      * function.
      ***/
     ldpc_param_init(&param);
-    param.h_matrix = H;
+    param.code = H;
     param.max_iter = 30; //Number of decoder iterations to run
     param.num_threads = 16;
 
@@ -113,10 +130,11 @@ int main() {
 
         /***
          * Decode a 128 x H->N input sequence, into a 128 x H->K output bit sequence.
-         * The decoder currently does NOT check wether the output bits are valid!
+         * The decoder returns the number of decoded codewords that satisfy all
+         * parity checks. ldpc_decoder_status gives the result of each codeword.
          ***/
-        for (r=0;r<1;r++)
-            ldpc_decode(decoder, chan, dec);
+        valid = ldpc_decode(decoder, chan, dec);
+        fprintf(stderr, "Valid codewords: %d/128\n", valid);
 
         /***
          * Calculate the bit-error-ratio (BER) by comparing to the
@@ -135,6 +153,75 @@ int main() {
     ber = 1-(((float)csum)/(float)(128*H->K*ROUNDS));
     fprintf(stderr, "Total BER: %f (%d)\n", ber, 128*H->K*ROUNDS-csum);
 
+    /* The decoder keeps counters of where the decoding time was spent */
+    ldpc_decoder_stats(decoder, &stats);
+    fprintf(stderr, "Cycles per batch: interleave %llu, iterations %llu, hard decision %llu, copy back %llu\n",
+            stats.interleave_cycles/stats.batches, stats.iteration_cycles/stats.batches,
+            stats.hard_decision_cycles/stats.batches, stats.copy_back_cycles/stats.batches);
+    fprintf(stderr, "Iterations: %llu, failed codewords: %llu/%llu\n", stats.iterations, stats.failed_frames, stats.frames);
+
+    /***
+     * Several decoders can share a fixed set of worker threads through a scheduler.
+     * Each decoder is attached as a channel with a priority and a weight, and decodes
+     * on the worker that picks its batch, so it must be initialized with num_threads 0.
+     * Here channel 0 is served before the others, and channel 1 gets three times the
+     * decoding time of channel 2. All of them decode the last round's input again.
+     ***/
+    sched = ldpc_sched_create(2);
+    if (!sched)
+        return 1;
+    if (ldpc_sched_attach(sched, decoder, 0, 1)) {
+        fprintf(stderr, "Scheduler accepted a decoder with worker threads\n");
+        failed = 1;
+    }
+
+    param.num_threads = 0;
+    for (c=0;c<SCHED_CHANNELS;c++) {
+        sched_dec[c] = ldpc_init(&param);
+        sched_chan[c] = ldpc_sched_attach(sched, sched_dec[c], c == 0 ? 1 : 0, c == 1 ? 3 : 1);
+        if (!sched_chan[c])
+            return 1;
+    }
+
+    for (b=0;b<SCHED_BATCHES;b++) {
+        for (c=0;c<SCHED_CHANNELS;c++) {
+            sched_out[c][b] = (unsigned char *)malloc(128*H->K*sizeof(unsigned char));
+            sched_valid[c][b] = -1;
+            ldpc_sched_submit(sched_chan[c], chan, sched_out[c][b], sched_done, &sched_valid[c][b]);
+        }
+    }
+
+    for (c=0;c<SCHED_CHANNELS;c++) {
+        ldpc_sched_wait(sched_chan[c]);
+
+        sum = 0;
+        for (b=0;b<SCHED_BATCHES;b++) {
+            for (r=0;r<128*H->K;r++)
+                sum += sched_out[c][b][r] == dec[r] ? 0 : 1;
+            if (sched_valid[c][b] != valid) {
+                fprintf(stderr, "Channel %d, batch %d: %d valid codewords instead of %d\n", c, b, sched_valid[c][b], valid);
+                failed = 1;
+            }
+            free(sched_out[c][b]);
+        }
+        printf("Channel %d differences: %d\n", c, sum);
+        if (sum)
+            failed = 1;
+
+        /* The scheduler counts the batches of each channel and how long they waited */
+        ldpc_sched_stats(sched_chan[c], &sched_stats);
+        fprintf(stderr, "Channel %d: batches %llu, queue %llu us (max %llu us), decoding %llu us\n", c,
+                sched_stats.batches, sched_stats.queue_us, sched_stats.max_queue_us, sched_stats.decode_us);
+        if (sched_stats.batches != SCHED_BATCHES || sched_stats.max_queue_us > sched_stats.queue_us) {
+            fprintf(stderr, "Channel %d: unexpected statistics\n", c);
+            failed = 1;
+        }
+
+        ldpc_sched_detach(sched_chan[c]);
+        ldpc_destroy(sched_dec[c]);
+    }
+    ldpc_sched_destroy(sched);
+
     /* Free decoder resources, param (including H matrix), and other
      * allocated memory */
 
@@ -146,5 +233,5 @@ int main() {
     free(chan);
 
 
-    return 0;
+    return failed;
 }